@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Adaptive duty cycle. While the bus is idle the window length backs
+ * off towards max, so an idle device sees few profiler wakeups; as soon
+ * as a window gets busy it drops straight to min to resolve the burst.
+ * The counters keep running across the whole window either way, so no
+ * traffic goes uncounted, only the time resolution changes.
+ *
+ * --adaptive[=min=MS][,max=MS][,idle=PERCENT][,busy=PERCENT][,hold=N]
+ *
+ *   min    shortest window (default 100 ms)
+ *   max    longest window, at most 4000 ms to stay clear of the cycle
+ *          counter overflow (default 4000 ms)
+ *   idle   busy% below which a window counts as idle (default 5)
+ *   busy   busy% above which sampling escalates to min (default 20)
+ *   hold   idle windows in a row before the window doubles (default 3)
+ *
+ * Busy% is the larger one of both controllers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+static bool enabled;
+static unsigned int min_ms = 100;
+static unsigned int max_ms = 4000;
+static double idle = 5.0;
+static double busy = 20.0;
+static unsigned int hold = 3;
+
+static unsigned int idle_windows;
+static uint64_t windows, escalations;
+static uint64_t window_ms_sum;
+
+static int adapt_option(const char *opt)
+{
+	const char *val = strchr(opt, '=');
+	char *end;
+
+	if (!val)
+		return -1;
+	val++;
+
+	if (strncmp(opt, "min=", 4) == 0)
+		min_ms = strtoul(val, &end, 0);
+	else if (strncmp(opt, "max=", 4) == 0)
+		max_ms = strtoul(val, &end, 0);
+	else if (strncmp(opt, "idle=", 5) == 0)
+		idle = strtod(val, &end);
+	else if (strncmp(opt, "busy=", 5) == 0)
+		busy = strtod(val, &end);
+	else if (strncmp(opt, "hold=", 5) == 0)
+		hold = strtoul(val, &end, 0);
+	else
+		return -1;
+
+	return *end ? -1 : 0;
+}
+
+int adapt_init(const char *spec)
+{
+	char *copy, *opt, *saveptr;
+	int err = 0;
+
+	enabled = true;
+	if (!spec)
+		return 0;
+
+	copy = strdup(spec);
+	if (!copy)
+		return -1;
+
+	for (opt = strtok_r(copy, ",", &saveptr); opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (adapt_option(opt)) {
+			fprintf(stderr, "invalid adaptive option '%s'\n", opt);
+			err = -1;
+			break;
+		}
+	}
+	free(copy);
+	if (err)
+		return -1;
+
+	if (!min_ms || min_ms > max_ms || max_ms > 4000 || idle >= busy) {
+		fprintf(stderr, "adaptive needs 0 < min <= max <= 4000 and idle < busy\n");
+		return -1;
+	}
+	return 0;
+}
+
+bool adapt_enabled(void)
+{
+	return enabled;
+}
+
+/* Sampling starts relaxed, the first busy window escalates */
+unsigned int adapt_initial_ms(void)
+{
+	return max_ms;
+}
+
+/* Pick the length of the next window from the one just finished */
+unsigned int adapt_next(const struct perf_sample *s, unsigned int interval_ms)
+{
+	double b = mmdc_busy(&s->mmdc[0]);
+
+	if (mmdc_busy(&s->mmdc[1]) > b)
+		b = mmdc_busy(&s->mmdc[1]);
+
+	windows++;
+	window_ms_sum += s->duration_ns / 1000000;
+
+	/* suspended windows say nothing about the load */
+	if (s->suspended_ns)
+		return interval_ms;
+
+	if (b > busy) {
+		idle_windows = 0;
+		if (interval_ms > min_ms)
+			escalations++;
+		return min_ms;
+	}
+
+	if (b >= idle) {
+		idle_windows = 0;
+		return interval_ms;
+	}
+
+	if (++idle_windows < hold)
+		return interval_ms;
+	idle_windows = 0;
+	interval_ms *= 2;
+	if (interval_ms > max_ms)
+		interval_ms = max_ms;
+	return interval_ms < min_ms ? min_ms : interval_ms;
+}
+
+void adapt_report(FILE *f)
+{
+	if (!enabled || !windows)
+		return;
+
+	fprintf(f, "adaptive: %llu windows, mean %.0f ms, %llu escalations\n",
+		(unsigned long long)windows,
+		(double)window_ms_sum / windows,
+		(unsigned long long)escalations);
+}
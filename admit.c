@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Publisher side of the admission control segment, see ddrstat_admit.h.
+ *
+ * --admit[=name=NAME][,limit=PERCENT][,token=PERCENT][,critical=PERCENT]
+ *        [,smooth=WEIGHT][,group=GROUP]
+ *
+ *   name      shared memory name (default /imx6_ddrstat_admit)
+ *   limit     busy% up to which work is admitted (default 70)
+ *   token     busy% headroom per token (default 5)
+ *   critical  busy% at which no work is admitted (default 90)
+ *   smooth    weight of a new window in the smoothed busy% (default 0.3)
+ *   group     only this group may use the segment, instead of everyone
+ *
+ * Busy% is the larger one of both controllers.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <signal.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "ddrstat_admit.h"
+#include "imx6_ddrstat.h"
+
+static bool enabled;
+static char *name;
+static double limit = 70.0;
+static double token = 5.0;
+static double critical = 90.0;
+static double smooth = 0.3;
+static char *group;
+
+static struct ddrstat_admit *admit;
+static bool primed;
+static uint32_t tokens_last;
+static uint64_t windows, critical_windows, tokens_granted, tokens_taken;
+
+static int admit_option(const char *opt)
+{
+	const char *val = strchr(opt, '=');
+	char *end = "";
+
+	if (!val)
+		return -1;
+	val++;
+
+	if (strncmp(opt, "name=", 5) == 0) {
+		if (*val != '/')
+			return -1;
+		name = strdup(val);
+	} else if (strncmp(opt, "group=", 6) == 0) {
+		group = strdup(val);
+	} else if (strncmp(opt, "limit=", 6) == 0) {
+		limit = strtod(val, &end);
+	} else if (strncmp(opt, "token=", 6) == 0) {
+		token = strtod(val, &end);
+	} else if (strncmp(opt, "critical=", 9) == 0) {
+		critical = strtod(val, &end);
+	} else if (strncmp(opt, "smooth=", 7) == 0) {
+		smooth = strtod(val, &end);
+	} else {
+		return -1;
+	}
+
+	return *end ? -1 : 0;
+}
+
+int admit_init(const char *spec)
+{
+	char *copy, *opt, *saveptr;
+	int err = 0;
+
+	enabled = true;
+	if (spec) {
+		copy = strdup(spec);
+		if (!copy)
+			return -1;
+		for (opt = strtok_r(copy, ",", &saveptr); opt;
+		     opt = strtok_r(NULL, ",", &saveptr)) {
+			if (admit_option(opt)) {
+				fprintf(stderr, "invalid admit option '%s'\n",
+					opt);
+				err = -1;
+				break;
+			}
+		}
+		free(copy);
+		if (err)
+			return -1;
+	}
+
+	if (token <= 0.0 || limit <= 0.0 || limit > critical ||
+	    smooth <= 0.0 || smooth > 1.0) {
+		fprintf(stderr, "admit needs token > 0, 0 < limit <= critical and 0 < smooth <= 1\n");
+		return -1;
+	}
+	return 0;
+}
+
+bool admit_enabled(void)
+{
+	return enabled;
+}
+
+/* Create the segment, readable and writable by the clients */
+int admit_open(unsigned int interval_ms)
+{
+	const char *shm_name = name ? name : DDRSTAT_ADMIT_NAME;
+	struct group *gr = NULL;
+	mode_t mode = group ? 0660 : 0666;
+	struct ddrstat_admit *old;
+	struct timespec now;
+	uint32_t pid;
+	int fd;
+
+	if (!enabled)
+		return 0;
+
+	if (group) {
+		gr = getgrnam(group);
+		if (!gr) {
+			fprintf(stderr, "admit: unknown group '%s'\n", group);
+			return -1;
+		}
+	}
+
+	/* another instance may still be publishing, else it crashed */
+	old = ddrstat_admit_open(shm_name);
+	if (old) {
+		pid = __atomic_load_n(&old->publisher_pid, __ATOMIC_ACQUIRE);
+		ddrstat_admit_close(old);
+		if (pid && (kill(pid, 0) == 0 || errno == EPERM)) {
+			fprintf(stderr, "admit: %s is published by pid %u\n",
+				shm_name, pid);
+			return -1;
+		}
+	}
+	shm_unlink(shm_name);
+	fd = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL, mode);
+	if (fd < 0)
+		goto err;
+	if ((gr && fchown(fd, -1, gr->gr_gid)) || fchmod(fd, mode) ||
+	    ftruncate(fd, sizeof(*admit))) {
+		close(fd);
+		goto err_unlink;
+	}
+	admit = mmap(NULL, sizeof(*admit), PROT_READ | PROT_WRITE,
+		     MAP_SHARED, fd, 0);
+	close(fd);
+	if (admit == MAP_FAILED) {
+		admit = NULL;
+		goto err_unlink;
+	}
+
+	admit->version = DDRSTAT_ADMIT_VERSION;
+	admit->publisher_pid = getpid();
+	admit->interval_ms = interval_ms;
+	admit->limit = limit;
+	admit->token = token;
+	/* nothing is admitted before the first window was measured */
+	admit->critical = 1;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	admit->updated_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+	__atomic_store_n(&admit->magic, DDRSTAT_ADMIT_MAGIC, __ATOMIC_RELEASE);
+	return 0;
+
+err_unlink:
+	shm_unlink(shm_name);
+err:
+	fprintf(stderr, "admit: %s: %s\n", shm_name, strerror(errno));
+	return -1;
+}
+
+/* Publish the load of a window and refill the token bucket */
+void admit_update(const struct perf_sample *s, unsigned int interval_ms)
+{
+	struct timespec now;
+	double b = mmdc_busy(&s->mmdc[0]);
+	double worst;
+	uint32_t tokens = 0;
+
+	if (!admit || s->suspended_ns || !s->duration_ns)
+		return;
+
+	if (mmdc_busy(&s->mmdc[1]) > b)
+		b = mmdc_busy(&s->mmdc[1]);
+
+	windows++;
+	tokens_taken += tokens_last - __atomic_load_n(&admit->tokens,
+						      __ATOMIC_RELAXED);
+
+	__atomic_store_n(&admit->seq, admit->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	admit->smoothed = primed ? smooth * b + (1.0 - smooth) *
+			  admit->smoothed : b;
+	primed = true;
+	admit->busy = b;
+	admit->interval_ms = interval_ms;
+	admit->critical = b >= critical;
+	worst = b > admit->smoothed ? b : admit->smoothed;
+	if (!admit->critical && worst < limit)
+		tokens = (limit - worst) / token;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	admit->updated_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+	__atomic_store_n(&admit->tokens, tokens, __ATOMIC_RELAXED);
+	tokens_last = tokens;
+
+	__atomic_store_n(&admit->seq, admit->seq + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&admit->window, admit->window + 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &admit->window, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+
+	critical_windows += admit->critical;
+	tokens_granted += tokens;
+}
+
+/* Tell the clients nobody is counting any more and remove the segment */
+void admit_exit(void)
+{
+	if (!admit)
+		return;
+
+	__atomic_store_n(&admit->publisher_pid, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&admit->window, admit->window + 1, __ATOMIC_RELEASE);
+	syscall(SYS_futex, &admit->window, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+	shm_unlink(name ? name : DDRSTAT_ADMIT_NAME);
+	munmap(admit, sizeof(*admit));
+	admit = NULL;
+}
+
+void admit_report(FILE *f)
+{
+	if (!enabled || !windows)
+		return;
+
+	fprintf(f, "admit: %llu windows, %llu critical, %llu of %llu tokens taken\n",
+		(unsigned long long)windows,
+		(unsigned long long)critical_windows,
+		(unsigned long long)tokens_taken,
+		(unsigned long long)tokens_granted);
+}
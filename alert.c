@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Online anomaly detection. For every AXI filter (and unfiltered
+ * windows) each metric keeps an exponentially weighted mean and
+ * variance, so memory and per-window cost are constant. A window whose
+ * value is more than z standard deviations away from the mean raises an
+ * alert; the alert clears once the metric is back within z / 2.
+ *
+ * --alert=TARGET[,z=N][,alpha=A][,warmup=N]
+ *
+ *   TARGET   '-' for stdout (default), syslog, or exec:COMMAND to run
+ *            COMMAND (without commas) with the alert in DDRSTAT_*
+ *            environment variables
+ *   z        threshold in standard deviations (default 4)
+ *   alpha    weight of a new window (default 0.05)
+ *   warmup   windows to learn before alerting (default 30)
+ */
+
+#include <math.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+
+#include "imx6_ddrstat.h"
+
+enum alert_metric {
+	ALERT_BUSY,
+	ALERT_READ,
+	ALERT_WRITE,
+	ALERT_READ_SIZE,
+	NUM_ALERT_METRICS,
+};
+
+static const struct {
+	const char *name;
+	double floor;	/* smallest standard deviation taken seriously */
+} alert_metrics[NUM_ALERT_METRICS] = {
+	[ALERT_BUSY] = { "busy", 0.5 },
+	[ALERT_READ] = { "read_mbps", 1.0 },
+	[ALERT_WRITE] = { "write_mbps", 1.0 },
+	[ALERT_READ_SIZE] = { "read_size", 1.0 },
+};
+
+enum alert_target {
+	ALERT_STDOUT,
+	ALERT_SYSLOG,
+	ALERT_EXEC,
+};
+
+struct ewma {
+	double mean;
+	double var;
+	unsigned int n;
+	bool raised;
+};
+
+static bool enabled;
+static enum alert_target target;
+static char *command;
+static double threshold = 4.0;
+static double alpha = 0.05;
+static unsigned int warmup = 30;
+
+/* index 0 for unfiltered windows, then filters[] */
+static struct ewma state[64][NUM_ALERT_METRICS];
+
+static int alert_option(const char *opt)
+{
+	const char *val = strchr(opt, '=');
+	char *end;
+
+	if (!val)
+		return -1;
+	val++;
+
+	if (strncmp(opt, "z=", 2) == 0)
+		threshold = strtod(val, &end);
+	else if (strncmp(opt, "alpha=", 6) == 0)
+		alpha = strtod(val, &end);
+	else if (strncmp(opt, "warmup=", 7) == 0)
+		warmup = strtoul(val, &end, 0);
+	else
+		return -1;
+
+	if (*end || threshold <= 0.0 || alpha <= 0.0 || alpha >= 1.0)
+		return -1;
+	return 0;
+}
+
+int alert_init(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *opts, *opt, *saveptr;
+
+	if (!copy)
+		return -1;
+
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+
+	if (!*copy || strcmp(copy, "-") == 0) {
+		target = ALERT_STDOUT;
+	} else if (strcmp(copy, "syslog") == 0) {
+		target = ALERT_SYSLOG;
+		openlog("imx6_ddrstat", LOG_PID, LOG_DAEMON);
+	} else if (strncmp(copy, "exec:", 5) == 0 && copy[5]) {
+		target = ALERT_EXEC;
+		command = strdup(copy + 5);
+	} else {
+		fprintf(stderr, "invalid alert target '%s'\n", copy);
+		goto err;
+	}
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (alert_option(opt)) {
+			fprintf(stderr, "invalid alert option '%s'\n", opt);
+			goto err;
+		}
+	}
+
+	free(copy);
+	enabled = true;
+	return 0;
+err:
+	free(copy);
+	return -1;
+}
+
+bool alert_to_stdout(void)
+{
+	return enabled && target == ALERT_STDOUT;
+}
+
+static void alert_exec(const char *event, const char *filter,
+		       const char *metric, uint64_t window, double value,
+		       double mean, double z)
+{
+	char env[8][64];
+	char *envp[ARRAY_SIZE(env) + 1];
+	char *argv[] = { "/bin/sh", "-c", command, NULL };
+	unsigned int i;
+	pid_t pid;
+
+	snprintf(env[0], sizeof(env[0]), "DDRSTAT_EVENT=%s", event);
+	snprintf(env[1], sizeof(env[1]), "DDRSTAT_FILTER=%s", filter);
+	snprintf(env[2], sizeof(env[2]), "DDRSTAT_METRIC=%s", metric);
+	snprintf(env[3], sizeof(env[3]), "DDRSTAT_WINDOW=%llu",
+		 (unsigned long long)window);
+	snprintf(env[4], sizeof(env[4]), "DDRSTAT_VALUE=%.3f", value);
+	snprintf(env[5], sizeof(env[5]), "DDRSTAT_MEAN=%.3f", mean);
+	snprintf(env[6], sizeof(env[6]), "DDRSTAT_Z=%.2f", z);
+	snprintf(env[7], sizeof(env[7]), "PATH=/usr/sbin:/usr/bin:/sbin:/bin");
+	for (i = 0; i < ARRAY_SIZE(env); i++)
+		envp[i] = env[i];
+	envp[i] = NULL;
+
+	/* the hook runs on its own, the sampler does not wait for it */
+	if (posix_spawn(&pid, argv[0], NULL, NULL, argv, envp))
+		perror("alert hook");
+}
+
+static void alert_emit(const char *event, const char *filter,
+		       const char *metric, uint64_t window, double value,
+		       double mean, double z)
+{
+	switch (target) {
+	case ALERT_STDOUT:
+		printf("%s window %llu filter %s %s %.2f mean %.2f z %.1f\n",
+		       event, (unsigned long long)window, filter, metric,
+		       value, mean, z);
+		fflush(stdout);
+		break;
+	case ALERT_SYSLOG:
+		syslog(LOG_WARNING,
+		       "%s window %llu filter %s %s %.2f mean %.2f z %.1f",
+		       event, (unsigned long long)window, filter, metric,
+		       value, mean, z);
+		break;
+	case ALERT_EXEC:
+		alert_exec(event, filter, metric, window, value, mean, z);
+		break;
+	}
+}
+
+/* Score x against the history so far, then fold it in */
+static double ewma_update(struct ewma *e, double x, double floor)
+{
+	double diff = x - e->mean;
+	double sd = fmax(sqrt(e->var), floor);
+	double z = e->n ? diff / sd : 0.0;
+	double incr = alpha * diff;
+
+	if (!e->n) {
+		e->mean = x;
+	} else {
+		e->mean += incr;
+		e->var = (1.0 - alpha) * (e->var + diff * incr);
+	}
+	e->n++;
+	return z;
+}
+
+void alert_check(uint64_t window, const struct perf_sample *s)
+{
+	const struct mmdc_stats *m0 = &s->mmdc[0], *m1 = &s->mmdc[1];
+	struct ewma *e = state[s->filter ? s->filter - filters + 1 : 0];
+	const char *filter = s->filter ? s->filter->name : "all";
+	double v[NUM_ALERT_METRICS];
+	bool valid[NUM_ALERT_METRICS] = { true, true, true, true };
+	uint32_t reads = m0->read_accesses + m1->read_accesses;
+	double z, mean;
+	int m;
+
+	if (!enabled)
+		return;
+
+	if (s->suspended_ns || !(m0->cycles || m1->cycles))
+		return;
+
+	v[ALERT_BUSY] = fmax(mmdc_busy(m0), mmdc_busy(m1));
+	v[ALERT_READ] = perf_rate(s, m0->read_bytes + m1->read_bytes) / 1e6;
+	v[ALERT_WRITE] = perf_rate(s, m0->write_bytes + m1->write_bytes) / 1e6;
+	v[ALERT_READ_SIZE] = reads ?
+		(double)(m0->read_bytes + m1->read_bytes) / reads : 0.0;
+	valid[ALERT_READ_SIZE] = reads > 0;
+
+	for (m = 0; m < NUM_ALERT_METRICS; m++) {
+		if (!valid[m])
+			continue;
+		mean = e[m].mean;
+		z = ewma_update(&e[m], v[m], alert_metrics[m].floor);
+		if (e[m].n <= warmup)
+			continue;
+
+		if (!e[m].raised && fabs(z) > threshold) {
+			e[m].raised = true;
+			alert_emit("alert", filter, alert_metrics[m].name,
+				   window, v[m], mean, z);
+		} else if (e[m].raised && fabs(z) < threshold / 2) {
+			e[m].raised = false;
+			alert_emit("clear", filter, alert_metrics[m].name,
+				   window, v[m], mean, z);
+		}
+	}
+}
+
+void alert_exit(void)
+{
+	if (!enabled)
+		return;
+	if (target == ALERT_SYSLOG)
+		closelog();
+	free(command);
+	enabled = false;
+}
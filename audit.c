@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Burst efficiency audit. Every access occupies the bus for at least a
+ * full burst (BL8, 4 DDR clocks), so a master issuing accesses smaller
+ * than the burst wastes the rest of it. From the per-filter totals of a
+ * sweep this ranks the masters by the bandwidth they waste that way.
+ *
+ * The MMDC counts busy cycles for all traffic regardless of the AXI
+ * filter, so busy cycles per byte of a single master are estimated from
+ * its access sizes; the measured value is shown for unfiltered windows.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "imx6_ddrstat.h"
+
+#define BURST_CYCLES	4	/* BL8 on a DDR bus */
+
+struct audit_row {
+	const char *name;
+	double rd_mbps, wr_mbps;
+	double rd_size, wr_size;
+	double rd_mix;
+	double busy_per_byte;
+	double efficiency;
+	double wasted_mbps;
+};
+
+static int audit_cmp(const void *a, const void *b)
+{
+	const struct audit_row *x = a, *y = b;
+
+	return x->wasted_mbps < y->wasted_mbps ? 1 :
+	       x->wasted_mbps > y->wasted_mbps ? -1 : 0;
+}
+
+/* bursts needed for accesses of the given average size */
+static double audit_bursts(double accesses, double size, unsigned int burst)
+{
+	/* the average of equal sizes may come out a hair above them */
+	return accesses * ceil(size / burst - 1e-6);
+}
+
+/* measured: take busy cycles from the counters, not from the bursts */
+static void audit_fill(struct audit_row *r, const char *name,
+		       const struct perf_totals *t, unsigned int burst,
+		       bool measured)
+{
+	double s = t->duration_ns * 1e-9;
+	double rd = 0, wr = 0, rda = 0, wra = 0, busy = 0, bursts;
+	int c;
+
+	for (c = 0; c < 2; c++) {
+		rd += t->mmdc[c].read_bytes;
+		wr += t->mmdc[c].write_bytes;
+		rda += t->mmdc[c].read_accesses;
+		wra += t->mmdc[c].write_accesses;
+		busy += t->mmdc[c].busy_cycles;
+	}
+
+	r->name = name;
+	r->rd_mbps = s > 0 ? rd / s / 1e6 : 0.0;
+	r->wr_mbps = s > 0 ? wr / s / 1e6 : 0.0;
+	r->rd_size = rda ? rd / rda : 0.0;
+	r->wr_size = wra ? wr / wra : 0.0;
+	r->rd_mix = rd + wr > 0 ? 100.0 * rd / (rd + wr) : 0.0;
+
+	bursts = audit_bursts(rda, r->rd_size, burst) +
+		 audit_bursts(wra, r->wr_size, burst);
+	r->efficiency = bursts ? 100.0 * (rd + wr) / (bursts * burst) : 0.0;
+	r->wasted_mbps = s > 0 ?
+		fmax(bursts * burst - rd - wr, 0.0) / s / 1e6 : 0.0;
+	r->busy_per_byte = rd + wr > 0 ?
+		(measured ? busy : bursts * BURST_CYCLES) / (rd + wr) : 0.0;
+}
+
+/*
+ * Print the audit for totals[] as kept by the sampler, index 0 for
+ * unfiltered windows and i for filters[i - 1]. burst is the full burst
+ * size in bytes, 64 for a 64-bit bus.
+ */
+void audit_report(FILE *f, const struct perf_totals *totals,
+		  unsigned int num, unsigned int burst)
+{
+	struct audit_row *rows, all;
+	unsigned int i, n = 0;
+
+	rows = calloc(num, sizeof(*rows));
+	if (!rows)
+		return;
+
+	for (i = 1; i < num; i++)
+		if (totals[i].windows && totals[i].duration_ns)
+			audit_fill(&rows[n++], filters[i - 1].name,
+				   &totals[i], burst, false);
+	qsort(rows, n, sizeof(*rows), audit_cmp);
+
+	fprintf(f, "burst audit, %u byte bursts, ranked by wasted bandwidth\n",
+		burst);
+	fprintf(f, "%-12s %9s %9s %7s %7s %6s %9s %6s %10s\n", "MASTER",
+		"RD MB/s", "WR MB/s", "RD SZ", "WR SZ", "RD%", "BUSY/B",
+		"EFF%", "WASTE MB/s");
+	for (i = 0; i < n; i++)
+		fprintf(f, "%-12s %9.1f %9.1f %7.1f %7.1f %6.1f %9.3f %6.1f %10.1f\n",
+			rows[i].name, rows[i].rd_mbps, rows[i].wr_mbps,
+			rows[i].rd_size, rows[i].wr_size, rows[i].rd_mix,
+			rows[i].busy_per_byte, rows[i].efficiency,
+			rows[i].wasted_mbps);
+
+	if (totals[0].windows && totals[0].duration_ns) {
+		audit_fill(&all, "(all)", &totals[0], burst, true);
+		fprintf(f, "%-12s %9.1f %9.1f %7.1f %7.1f %6.1f %9.3f %6.1f %10.1f\n",
+			all.name, all.rd_mbps, all.wr_mbps, all.rd_size,
+			all.wr_size, all.rd_mix, all.busy_per_byte,
+			all.efficiency, all.wasted_mbps);
+	}
+	if (!n)
+		fprintf(f, "no filtered windows, sweep over the masters first\n");
+
+	free(rows);
+}
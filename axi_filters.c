@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2012 Philipp Zabel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+/* Table 43-8. i.MX 6Dual/6Quad AXI ID */
+struct axi_filter filters[] = {
+	{ "arm-s0",    0b11100000000111, 0b00000000000000 },
+	{ "arm-s1",    0b11100000000111, 0b00000000000001 },
+	{ "ipu1",      0b11111111100111, 0b00000000000100 },
+	{ "ipu1-0",    0b11111111111111, 0b00000000000100 },
+	{ "ipu1-1",    0b11111111111111, 0b00000000001100 },
+	{ "ipu1-2",    0b11111111111111, 0b00000000010100 },
+	{ "ipu1-3",    0b11111111111111, 0b00000000011100 },
+	{ "ipu2",      0b11111111100111, 0b00000000000101 },
+	{ "ipu2-0",    0b11111111111111, 0b00000000000101 },
+	{ "ipu2-1",    0b11111111111111, 0b00000000001101 },
+	{ "ipu2-2",    0b11111111111111, 0b00000000010101 },
+	{ "ipu2-3",    0b11111111111111, 0b00000000011101 },
+	{ "gpu3d-a",   0b11110000111111, 0b00000000000010 },
+	{ "gpu2d-a",   0b11110000111111, 0b00000000001010 },
+	{ "vdoa",      0b11111100111111, 0b00000000010010 },
+	{ "openvg",    0b11110000111111, 0b00000000100010 },
+	{ "hdmi",      0b11111111111111, 0b00000100011010 },
+	{ "sdma-brst", 0b11111111111111, 0b00000101011010 },
+	{ "sdma-per",  0b11111111111111, 0b00000110011010 },
+	{ "caam",      0b00001111111111, 0b00000000011010 },
+	{ "usb",       0b11001111111111, 0b00000001011010 },
+	{ "enet",      0b11111111111111, 0b00000010011010 },
+	{ "hsi",       0b11111111111111, 0b00000011011010 },
+	{ "usdhc1",    0b11111111111111, 0b00000111011010 },
+	{ "gpu3d-b",   0b11110000111111, 0b00000000000011 },
+	/* the reference manual lists a second gpu3d-b instead of gpu2d-b */
+	{ "gpu2d-b",   0b11110000111111, 0b00000000001011 },
+	{ "vpu-prime", 0b11110000111111, 0b00000000010011 },
+	{ "pcie",      0b11100000111111, 0b00000000011011 },
+	{ "dap",       0b11111111111111, 0b00000000100011 },
+	{ "apbh-dma",  0b11111111111111, 0b00000010100011 },
+	{ "bch40",     0b00001111111111, 0b00000001100011 },
+	{ "sata",      0b11111111111111, 0b00000011100011 },
+	{ "mlb150",    0b11111111111111, 0b00000100100011 },
+	{ "usdhc2",    0b11111111111111, 0b00000101100011 },
+	{ "usdhc3",    0b11111111111111, 0b00000110100011 },
+	{ "usdhc4",    0b11111111111111, 0b00000111100011 },
+	{},
+};
+
+const struct axi_filter *axi_filter_find(const char *name)
+{
+	struct axi_filter *filter;
+
+	for (filter = filters; filter->name != NULL; filter++)
+		if (strcmp(filter->name, name) == 0)
+			return filter;
+
+	return NULL;
+}
+
+/*
+ * A filter is top level unless all AXI IDs it matches are also matched
+ * by another filter, as is the case for the single IPU channels.
+ */
+bool axi_filter_is_toplevel(const struct axi_filter *filter)
+{
+	struct axi_filter *f;
+
+	for (f = filters; f->name != NULL; f++) {
+		if (f == filter)
+			continue;
+		if ((f->axi_id_mask & filter->axi_id_mask) == f->axi_id_mask &&
+		    (filter->axi_id & f->axi_id_mask) ==
+		    (f->axi_id & f->axi_id_mask))
+			return false;
+	}
+
+	return true;
+}
+
+
+/* Find the filter programmed as PRF_AXI_ID/PRF_AXI_ID_MASK, if any */
+const struct axi_filter *axi_filter_lookup(unsigned short axi_id,
+					   unsigned short axi_id_mask)
+{
+	struct axi_filter *filter;
+
+	if (!axi_id_mask)
+		return NULL;
+
+	for (filter = filters; filter->name != NULL; filter++)
+		if (filter->axi_id == axi_id &&
+		    filter->axi_id_mask == axi_id_mask)
+			return filter;
+
+	return NULL;
+}
+
+/* Would an access with the given AXI ID be counted with this filter set? */
+bool axi_id_matches(unsigned short axi_id, unsigned short filter_id,
+		    unsigned short filter_mask)
+{
+	return (axi_id & filter_mask) == (filter_id & filter_mask);
+}
@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Bandwidth budgets. Each budget caps the summed bandwidth of one or
+ * more masters; the last measured bandwidth of every member is kept
+ * from the sweep and the sum checked whenever a member is measured.
+ * After the given number of windows over budget the actions fire, and
+ * after as many windows back below 90% of it they are undone.
+ *
+ * --budget=MASTER[+MASTER...]:MBPS[,action=ACTION...][,windows=N]
+ *          [,cooldown=SECONDS]
+ *
+ *   MASTER    a name from filters[], or all for the whole controller
+ *   action    exec:COMMAND     run COMMAND (without commas) with the
+ *                              event in DDRSTAT_* variables
+ *             cgroup:DIR:QUOTA write QUOTA to DIR/cpu.max, the
+ *                              previous value is restored on clear
+ *             signal:PID[:SIG] send SIG (default STOP) to PID, a STOP
+ *                              is followed by CONT on clear
+ *   windows   windows in a row over (or under) budget (default 1)
+ *   cooldown  seconds between two overrun actions (default 5)
+ *
+ * May be repeated. Every action is logged with its outcome to the file
+ * given by --budget-log, or to stderr.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "imx6_ddrstat.h"
+
+#define BUDGET_CLEAR	0.9
+
+enum budget_action_type {
+	BUDGET_EXEC,
+	BUDGET_CGROUP,
+	BUDGET_SIGNAL,
+};
+
+struct budget_action {
+	enum budget_action_type type;
+	char *arg;		/* command or cgroup directory */
+	char quota[32];
+	char saved[64];		/* cpu.max before the overrun */
+	pid_t pid;
+	int sig;
+};
+
+struct budget {
+	char *name;
+	unsigned int members[8];	/* indexed like totals, 0 is all */
+	unsigned int num_members;
+	double limit_mbps;
+	unsigned int windows;
+	double cooldown;
+
+	struct budget_action actions[4];
+	unsigned int num_actions;
+
+	double member_mbps[8];
+	double mbps;		/* last sum */
+	bool member_seen[8];
+	unsigned int over, under;
+	bool raised;
+	struct timespec last_action;
+	uint64_t overruns;
+};
+
+static struct budget budgets[16];
+static unsigned int num_budgets;
+static FILE *log_file;
+
+static const struct {
+	const char *name;
+	int sig;
+} signals[] = {
+	{ "STOP", SIGSTOP }, { "TSTP", SIGTSTP }, { "TERM", SIGTERM },
+	{ "KILL", SIGKILL }, { "USR1", SIGUSR1 }, { "USR2", SIGUSR2 },
+	{ "HUP", SIGHUP }, { "INT", SIGINT },
+};
+
+static const char *budget_signal_name(int sig)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(signals); i++)
+		if (signals[i].sig == sig)
+			return signals[i].name;
+	return "?";
+}
+
+static int budget_signal(const char *name)
+{
+	unsigned int i;
+
+	if (strncmp(name, "SIG", 3) == 0)
+		name += 3;
+	for (i = 0; i < ARRAY_SIZE(signals); i++)
+		if (strcmp(signals[i].name, name) == 0)
+			return signals[i].sig;
+	return -1;
+}
+
+static int budget_action_parse(struct budget *b, const char *spec)
+{
+	struct budget_action *a = &b->actions[b->num_actions];
+	const char *colon;
+	char *end;
+
+	if (b->num_actions == ARRAY_SIZE(b->actions))
+		return -1;
+
+	if (strncmp(spec, "exec:", 5) == 0 && spec[5]) {
+		a->type = BUDGET_EXEC;
+		a->arg = strdup(spec + 5);
+	} else if (strncmp(spec, "cgroup:", 7) == 0) {
+		colon = strrchr(spec + 7, ':');
+		if (!colon || colon == spec + 7 || !colon[1] ||
+		    strlen(colon + 1) >= sizeof(a->quota))
+			return -1;
+		a->type = BUDGET_CGROUP;
+		a->arg = strndup(spec + 7, colon - spec - 7);
+		strcpy(a->quota, colon + 1);
+		strtoul(a->quota, &end, 0);
+		if (*end)
+			return -1;
+	} else if (strncmp(spec, "signal:", 7) == 0) {
+		a->type = BUDGET_SIGNAL;
+		a->pid = strtol(spec + 7, &end, 0);
+		a->sig = SIGSTOP;
+		if (*end == ':')
+			a->sig = budget_signal(end + 1);
+		else if (*end)
+			return -1;
+		if (a->pid <= 0 || a->sig < 0)
+			return -1;
+	} else {
+		return -1;
+	}
+	b->num_actions++;
+	return 0;
+}
+
+static int budget_members(struct budget *b, char *list)
+{
+	const struct axi_filter *filter;
+	char *name, *saveptr;
+
+	for (name = strtok_r(list, "+", &saveptr); name;
+	     name = strtok_r(NULL, "+", &saveptr)) {
+		if (b->num_members == ARRAY_SIZE(b->members))
+			return -1;
+		if (strcmp(name, "all") == 0) {
+			b->members[b->num_members++] = 0;
+			continue;
+		}
+		filter = axi_filter_find(name);
+		if (!filter)
+			return -1;
+		b->members[b->num_members++] = filter - filters + 1;
+	}
+	return b->num_members ? 0 : -1;
+}
+
+int budget_add(const char *spec)
+{
+	struct budget *b = &budgets[num_budgets];
+	char *copy = strdup(spec);
+	char *opts, *opt, *colon, *end, *saveptr;
+
+	if (!copy || num_budgets == ARRAY_SIZE(budgets))
+		goto bad;
+	memset(b, 0, sizeof(*b));
+	b->windows = 1;
+	b->cooldown = 5.0;
+
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+	colon = strrchr(copy, ':');
+	if (!colon)
+		goto bad;
+	*colon = '\0';
+	b->limit_mbps = strtod(colon + 1, &end);
+	if (*end || b->limit_mbps <= 0.0)
+		goto bad;
+	b->name = strdup(copy);
+	if (budget_members(b, copy))
+		goto bad;
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (strncmp(opt, "action=", 7) == 0) {
+			if (budget_action_parse(b, opt + 7))
+				goto bad;
+		} else if (strncmp(opt, "windows=", 8) == 0) {
+			b->windows = strtoul(opt + 8, &end, 0);
+			if (*end || !b->windows)
+				goto bad;
+		} else if (strncmp(opt, "cooldown=", 9) == 0) {
+			b->cooldown = strtod(opt + 9, &end);
+			if (*end || b->cooldown < 0.0)
+				goto bad;
+		} else {
+			goto bad;
+		}
+	}
+
+	num_budgets++;
+	free(copy);
+	return 0;
+bad:
+	fprintf(stderr, "invalid budget '%s'\n", spec);
+	free(copy);
+	return -1;
+}
+
+bool budget_enabled(void)
+{
+	return num_budgets > 0;
+}
+
+/* Whether actions are logged to stderr, on the console */
+bool budget_log_to_console(void)
+{
+	return num_budgets > 0 && !log_file;
+}
+
+int budget_log_open(const char *path)
+{
+	log_file = fopen(path, "a");
+	if (!log_file) {
+		perror(path);
+		return -1;
+	}
+	setvbuf(log_file, NULL, _IOLBF, 0);
+	return 0;
+}
+
+/* Whether a member index appears in a budget before budgets[i].members[j] */
+static bool budget_listed(unsigned int i, unsigned int j)
+{
+	unsigned int m = budgets[i].members[j];
+	unsigned int k, l;
+
+	for (k = 0; k <= i; k++)
+		for (l = 0; l < (k < i ? budgets[k].num_members : j); l++)
+			if (budgets[k].members[l] == m)
+				return true;
+	return false;
+}
+
+/* Every member of every budget, each once */
+int budget_sweep_list(char *buf, size_t size)
+{
+	size_t len = 0;
+	unsigned int i, j, m;
+
+	buf[0] = '\0';
+	for (i = 0; i < num_budgets; i++) {
+		for (j = 0; j < budgets[i].num_members && len < size; j++) {
+			m = budgets[i].members[j];
+			if (budget_listed(i, j))
+				continue;
+			len += snprintf(buf + len, size - len, "%s%s",
+					len ? "," : "",
+					m ? filters[m - 1].name : "all");
+		}
+	}
+	return len < size ? 0 : -1;
+}
+
+static void budget_log(const struct budget *b, const char *event,
+		       double mbps, const char *action, int err)
+{
+	FILE *f = log_file ? log_file : stderr;
+	char stamp[32];
+	struct tm tm;
+	time_t now = time(NULL);
+
+	strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S",
+		 localtime_r(&now, &tm));
+	fprintf(f, "%s budget %s %s %.1f MB/s limit %.1f action %s %s\n",
+		stamp, b->name, event, mbps, b->limit_mbps, action,
+		err ? strerror(err) : "ok");
+}
+
+static int budget_cpu_max(struct budget_action *a, const char *val,
+			  char *old, size_t size)
+{
+	char path[512];
+	FILE *f;
+	int err = 0;
+
+	snprintf(path, sizeof(path), "%s/cpu.max", a->arg);
+	if (old) {
+		f = fopen(path, "r");
+		if (!f || !fgets(old, size, f))
+			err = errno ? errno : EIO;
+		if (f)
+			fclose(f);
+		if (err)
+			return err;
+		old[strcspn(old, "\n")] = '\0';
+	}
+
+	f = fopen(path, "w");
+	if (!f)
+		return errno;
+	if (fputs(val, f) < 0)
+		err = errno;
+	if (fclose(f) && !err)
+		err = errno;
+	return err;
+}
+
+static int budget_exec(const struct budget *b, const char *command,
+		       const char *event, double mbps)
+{
+	char env[4][128];
+	char *envp[ARRAY_SIZE(env) + 2];
+	char *argv[] = { "/bin/sh", "-c", (char *)command, NULL };
+	unsigned int i;
+	pid_t pid;
+
+	snprintf(env[0], sizeof(env[0]), "DDRSTAT_EVENT=%s", event);
+	snprintf(env[1], sizeof(env[1]), "DDRSTAT_BUDGET=%s", b->name);
+	snprintf(env[2], sizeof(env[2]), "DDRSTAT_MBPS=%.1f", mbps);
+	snprintf(env[3], sizeof(env[3]), "DDRSTAT_LIMIT=%.1f", b->limit_mbps);
+	for (i = 0; i < ARRAY_SIZE(env); i++)
+		envp[i] = env[i];
+	envp[i++] = "PATH=/usr/sbin:/usr/bin:/sbin:/bin";
+	envp[i] = NULL;
+
+	return posix_spawn(&pid, argv[0], NULL, NULL, argv, envp);
+}
+
+/* Fire every action of a budget on overrun, undo them otherwise */
+static void budget_act(struct budget *b, const char *event, double mbps)
+{
+	bool clear = strcmp(event, "overrun") != 0;
+	struct budget_action *a;
+	char desc[600], val[64];
+	unsigned int i;
+	int err;
+
+	for (i = 0; i < b->num_actions; i++) {
+		a = &b->actions[i];
+		err = 0;
+		switch (a->type) {
+		case BUDGET_EXEC:
+			err = budget_exec(b, a->arg, event, mbps);
+			snprintf(desc, sizeof(desc), "exec:%s", a->arg);
+			break;
+		case BUDGET_CGROUP:
+			if (!clear) {
+				snprintf(val, sizeof(val), "%s", a->quota);
+				err = budget_cpu_max(a, val, a->saved,
+						     sizeof(a->saved));
+			} else if (a->saved[0]) {
+				snprintf(val, sizeof(val), "%s", a->saved);
+				err = budget_cpu_max(a, val, NULL, 0);
+				a->saved[0] = '\0';
+			} else {
+				continue;
+			}
+			snprintf(desc, sizeof(desc), "cgroup:%s cpu.max=%s",
+				 a->arg, val);
+			break;
+		case BUDGET_SIGNAL:
+			if (clear && a->sig != SIGSTOP)
+				continue;
+			err = kill(a->pid, clear ? SIGCONT : a->sig) ?
+			      errno : 0;
+			snprintf(desc, sizeof(desc), "signal:%d:%s", a->pid,
+				 clear ? "CONT" : budget_signal_name(a->sig));
+			break;
+		}
+		budget_log(b, event, mbps, desc, err);
+	}
+	if (!b->num_actions)
+		budget_log(b, event, mbps, "none", 0);
+}
+
+void budget_check(const struct perf_sample *s)
+{
+	struct timespec now;
+	struct budget *b;
+	unsigned int i, j, idx;
+	double mbps, sum;
+	bool member, all_seen;
+
+	if (!num_budgets || s->suspended_ns || !s->duration_ns)
+		return;
+
+	idx = s->filter ? s->filter - filters + 1 : 0;
+	mbps = perf_rate(s, s->mmdc[0].read_bytes + s->mmdc[0].write_bytes +
+			 s->mmdc[1].read_bytes + s->mmdc[1].write_bytes) / 1e6;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	for (i = 0; i < num_budgets; i++) {
+		b = &budgets[i];
+		member = false;
+		all_seen = true;
+		sum = 0.0;
+		for (j = 0; j < b->num_members; j++) {
+			if (b->members[j] == idx) {
+				b->member_mbps[j] = mbps;
+				b->member_seen[j] = true;
+				member = true;
+			}
+			all_seen = all_seen && b->member_seen[j];
+			sum += b->member_mbps[j];
+		}
+		if (!member || !all_seen)
+			continue;
+		b->mbps = sum;
+
+		if (sum > b->limit_mbps) {
+			b->under = 0;
+			if (++b->over < b->windows || b->raised)
+				continue;
+			/* rate limit, the overrun stays pending */
+			if (b->overruns && (now.tv_sec - b->last_action.tv_sec) +
+			    (now.tv_nsec - b->last_action.tv_nsec) / 1e9 <
+			    b->cooldown)
+				continue;
+			b->raised = true;
+			b->overruns++;
+			b->last_action = now;
+			budget_act(b, "overrun", sum);
+		} else {
+			b->over = 0;
+			if (sum > b->limit_mbps * BUDGET_CLEAR) {
+				b->under = 0;
+				continue;
+			}
+			if (!b->raised || ++b->under < b->windows)
+				continue;
+			b->raised = false;
+			budget_act(b, "clear", sum);
+		}
+	}
+}
+
+/* Undo what is still in force and summarize */
+void budget_exit(void)
+{
+	struct budget *b;
+	unsigned int i;
+
+	for (i = 0; i < num_budgets; i++) {
+		b = &budgets[i];
+		if (b->raised) {
+			b->raised = false;
+			budget_act(b, "exit", b->mbps);
+		}
+		if (b->overruns)
+			fprintf(stderr, "budget %s: %llu overruns\n", b->name,
+				(unsigned long long)b->overruns);
+	}
+	num_budgets = 0;
+	if (log_file)
+		fclose(log_file);
+	log_file = NULL;
+}
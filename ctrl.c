@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Control socket. An orchestrator connects to a unix stream socket and
+ * sends one command per line. Commands are checked right away, but only
+ * take effect at the next window boundary, where everything received
+ * during the window is applied at once while the counters are frozen.
+ * The reply to each command is sent once it has been applied:
+ *
+ *   filter <master|all>      count one master only, stops a sweep
+ *   interval <seconds>       window length, e.g. 0.25 (at most 4)
+ *   sweep start [list]       start sweeping, list as for --sweep
+ *   sweep stop               stop sweeping, keep the current filter
+ *   reset                    clear the accumulated totals
+ *   snapshot                 last window and totals since the reset
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "imx6_ddrstat.h"
+
+#define CTRL_CLIENTS	16
+#define CTRL_DEFERRED	32
+#define CTRL_LINE	512
+
+/* a reply waiting for the boundary, NULL reply stands for a snapshot */
+struct ctrl_deferred {
+	const char *reply;
+	unsigned int gen;
+};
+
+struct ctrl_client {
+	int fd;
+	char in[CTRL_LINE];
+	size_t in_len;
+	struct ctrl_deferred deferred[CTRL_DEFERRED];
+	unsigned int num_deferred;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t thread;
+static bool running;
+static struct ctrl_request pending;
+static bool have_pending;
+static char *snapshot;
+/* bumped by every ctrl_take(), done_gen is the last one applied */
+static unsigned int take_gen, done_gen;
+
+static int listen_fd = -1;
+static int event_fd = -1;
+static char *path;
+static struct ctrl_client clients[CTRL_CLIENTS];
+static unsigned int num_clients;
+
+static void client_write(struct ctrl_client *c, const char *s)
+{
+	size_t len = strlen(s);
+
+	while (len) {
+		ssize_t ret = send(c->fd, s, len, MSG_NOSIGNAL);
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		s += ret;
+		len -= ret;
+	}
+}
+
+static void client_close(unsigned int i)
+{
+	close(clients[i].fd);
+	clients[i] = clients[--num_clients];
+}
+
+static bool sweep_list_valid(const char *list)
+{
+	char *names = strdup(list), *name, *saveptr;
+	bool valid = names != NULL;
+
+	for (name = strtok_r(names, ",", &saveptr); valid && name;
+	     name = strtok_r(NULL, ",", &saveptr))
+		if (strcmp(name, "all") && !axi_filter_find(name))
+			valid = false;
+	free(names);
+	return valid;
+}
+
+/* Returns the deferred reply, or sets *error */
+static const char *parse_command(char *line, const char **error)
+{
+	char *cmd, *arg, *arg2, *saveptr, *endp;
+	const struct axi_filter *filter;
+	double seconds;
+
+	cmd = strtok_r(line, " \t\r", &saveptr);
+	arg = strtok_r(NULL, " \t\r", &saveptr);
+	arg2 = strtok_r(NULL, " \t\r", &saveptr);
+	*error = NULL;
+
+	if (!cmd) {
+		*error = "error empty command\n";
+		return NULL;
+	}
+
+	if (strcmp(cmd, "filter") == 0 && arg) {
+		filter = axi_filter_find(arg);
+		if (!filter && strcmp(arg, "all")) {
+			*error = "error unknown AXI master\n";
+			return NULL;
+		}
+		pending.set_filter = true;
+		pending.filter = filter;
+		pending.sweep_start = false;
+		return "ok filter\n";
+	}
+
+	if (strcmp(cmd, "interval") == 0 && arg) {
+		seconds = strtod(arg, &endp);
+		if (*endp || seconds < 0.001 || seconds > 4.0) {
+			*error = "error interval must be 0.001 to 4 seconds\n";
+			return NULL;
+		}
+		pending.set_interval = true;
+		pending.interval_ms = seconds * 1000.0 + 0.5;
+		return "ok interval\n";
+	}
+
+	if (strcmp(cmd, "sweep") == 0 && arg && strcmp(arg, "start") == 0) {
+		if (arg2 && (strlen(arg2) >= sizeof(pending.sweep_list) ||
+			     !sweep_list_valid(arg2))) {
+			*error = "error invalid sweep list\n";
+			return NULL;
+		}
+		pending.sweep_start = true;
+		pending.set_filter = false;
+		snprintf(pending.sweep_list, sizeof(pending.sweep_list), "%s",
+			 arg2 ? arg2 : "");
+		return "ok sweep start\n";
+	}
+
+	if (strcmp(cmd, "sweep") == 0 && arg && strcmp(arg, "stop") == 0) {
+		pending.sweep_start = false;
+		pending.sweep_stop = true;
+		return "ok sweep stop\n";
+	}
+
+	if (strcmp(cmd, "reset") == 0) {
+		pending.reset = true;
+		return "ok reset\n";
+	}
+
+	if (strcmp(cmd, "snapshot") == 0) {
+		pending.snapshot = true;
+		return NULL;
+	}
+
+	*error = "error unknown command\n";
+	return NULL;
+}
+
+static void client_line(struct ctrl_client *c, char *line)
+{
+	const char *reply, *error;
+
+	if (c->num_deferred == CTRL_DEFERRED) {
+		client_write(c, "error too many queued commands\n");
+		return;
+	}
+
+	pthread_mutex_lock(&lock);
+	reply = parse_command(line, &error);
+	if (!error) {
+		have_pending = true;
+		c->deferred[c->num_deferred].reply = reply;
+		c->deferred[c->num_deferred++].gen = take_gen;
+	}
+	pthread_mutex_unlock(&lock);
+
+	if (error)
+		client_write(c, error);
+}
+
+static void client_read(unsigned int i)
+{
+	struct ctrl_client *c = &clients[i];
+	char *nl;
+	ssize_t ret;
+
+	ret = read(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len);
+	if (ret <= 0) {
+		if (ret < 0 && errno == EINTR)
+			return;
+		client_close(i);
+		return;
+	}
+	c->in_len += ret;
+	c->in[c->in_len] = '\0';
+
+	while ((nl = strchr(c->in, '\n'))) {
+		*nl = '\0';
+		client_line(c, c->in);
+		c->in_len -= nl + 1 - c->in;
+		memmove(c->in, nl + 1, c->in_len + 1);
+	}
+
+	if (c->in_len == sizeof(c->in) - 1) {
+		client_write(c, "error line too long\n");
+		client_close(i);
+	}
+}
+
+/* The sampler went past a boundary, send the replies that waited for it */
+static void flush_deferred(void)
+{
+	char *text = NULL;
+	unsigned int gen, i, j, k;
+
+	pthread_mutex_lock(&lock);
+	gen = done_gen;
+	if (snapshot)
+		text = strdup(snapshot);
+	pthread_mutex_unlock(&lock);
+
+	for (i = 0; i < num_clients; i++) {
+		struct ctrl_client *c = &clients[i];
+
+		/* commands queued after the take wait for the next boundary */
+		for (j = 0; j < c->num_deferred &&
+		     (int)(c->deferred[j].gen - gen) < 0; j++)
+			client_write(c, c->deferred[j].reply ?
+				     c->deferred[j].reply :
+				     text ? text : "error no data\n");
+		for (k = 0; j < c->num_deferred; j++, k++)
+			c->deferred[k] = c->deferred[j];
+		c->num_deferred = k;
+	}
+	free(text);
+}
+
+static void *ctrl_thread(void *arg)
+{
+	struct pollfd pfd[CTRL_CLIENTS + 2];
+	unsigned int i, n;
+	uint64_t val;
+
+	(void)arg;
+	while (running) {
+		pfd[0].fd = listen_fd;
+		pfd[0].events = POLLIN;
+		pfd[1].fd = event_fd;
+		pfd[1].events = POLLIN;
+		n = num_clients;
+		for (i = 0; i < n; i++) {
+			pfd[i + 2].fd = clients[i].fd;
+			pfd[i + 2].events = POLLIN;
+		}
+
+		if (poll(pfd, n + 2, 500) <= 0)
+			continue;
+
+		if (pfd[1].revents & POLLIN &&
+		    read(event_fd, &val, sizeof(val)) == sizeof(val))
+			flush_deferred();
+
+		for (i = n; i-- > 0;)
+			if (pfd[i + 2].revents)
+				client_read(i);
+
+		if (pfd[0].revents & POLLIN) {
+			int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+			if (fd >= 0 && num_clients < CTRL_CLIENTS) {
+				memset(&clients[num_clients], 0,
+				       sizeof(clients[0]));
+				clients[num_clients++].fd = fd;
+			} else if (fd >= 0) {
+				close(fd);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+int ctrl_init(const char *socket_path)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	sigset_t set, old;
+	int err;
+
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "control socket path too long\n");
+		return -1;
+	}
+	strcpy(addr.sun_path, socket_path);
+
+	listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	event_fd = eventfd(0, EFD_CLOEXEC);
+	if (listen_fd < 0 || event_fd < 0)
+		goto err;
+
+	unlink(socket_path);
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listen_fd, 4) < 0) {
+		perror(socket_path);
+		goto err;
+	}
+	chmod(socket_path, 0660);
+	path = strdup(socket_path);
+
+	/* leave SIGINT and SIGTERM to the sampling loop */
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+	running = true;
+	err = pthread_create(&thread, NULL, ctrl_thread, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err) {
+		running = false;
+		goto err;
+	}
+
+	return 0;
+err:
+	if (listen_fd >= 0)
+		close(listen_fd);
+	if (event_fd >= 0)
+		close(event_fd);
+	listen_fd = event_fd = -1;
+	return -1;
+}
+
+/* Fetch the commands received during the last window, if any */
+bool ctrl_take(struct ctrl_request *req)
+{
+	bool ret;
+
+	if (!running)
+		return false;
+
+	pthread_mutex_lock(&lock);
+	ret = have_pending;
+	if (ret) {
+		*req = pending;
+		memset(&pending, 0, sizeof(pending));
+		have_pending = false;
+		take_gen++;
+	}
+	pthread_mutex_unlock(&lock);
+
+	return ret;
+}
+
+/*
+ * Commands from ctrl_take() have been applied. For a snapshot request,
+ * text holds it and is freed by us.
+ */
+void ctrl_done(char *text)
+{
+	uint64_t one = 1;
+
+	pthread_mutex_lock(&lock);
+	if (text) {
+		free(snapshot);
+		snapshot = text;
+	}
+	done_gen = take_gen;
+	pthread_mutex_unlock(&lock);
+
+	if (write(event_fd, &one, sizeof(one)) != sizeof(one))
+		perror("control socket");
+}
+
+void ctrl_exit(void)
+{
+	unsigned int i;
+
+	if (!running)
+		return;
+
+	running = false;
+	ctrl_done(NULL);
+	pthread_join(thread, NULL);
+
+	for (i = 0; i < num_clients; i++)
+		close(clients[i].fd);
+	num_clients = 0;
+	close(listen_fd);
+	close(event_fd);
+	unlink(path);
+	free(path);
+	free(snapshot);
+}
@@ -0,0 +1,540 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Full screen live view. The screen is rendered into a character buffer
+ * and only the cells that changed since the previous update are sent to
+ * the terminal, so a refresh usually costs a few hundred bytes, which
+ * matters on a 115200 baud serial console.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "imx6_ddrstat.h"
+
+#define HISTORY		256
+#define BAR_WIDTH	30
+
+/* join two changed runs if fewer unchanged cells than this are between */
+#define RUN_GAP		8
+
+struct history {
+	float v[HISTORY];
+	unsigned int head;
+	unsigned int len;
+};
+
+struct master {
+	double read_bps;
+	double write_bps;
+	bool valid;
+};
+
+static struct {
+	int rows, cols;
+	char *cur;
+	char *prev;
+	bool full;
+	char *out;
+	size_t out_len;
+	size_t out_size;
+	size_t last_bytes;
+} scr;
+
+static struct termios saved_termios;
+static bool raw;
+static int input_fd = STDIN_FILENO;
+static volatile sig_atomic_t quit, resized;
+
+static unsigned int interval;
+static bool sweeping;
+static unsigned int updates;
+static unsigned int suspends;
+static struct perf_sample last;
+static bool controller_seen[2];
+static struct history busy[2], rd[2], wr[2];
+static struct master *masters;
+static unsigned int num_masters;
+
+static void history_add(struct history *h, float v)
+{
+	h->v[h->head] = v;
+	h->head = (h->head + 1) % HISTORY;
+	if (h->len < HISTORY)
+		h->len++;
+}
+
+/* i-th most recent entry, 0 being the newest */
+static float history_get(const struct history *h, unsigned int i)
+{
+	return h->v[(h->head + HISTORY - 1 - i) % HISTORY];
+}
+
+static void format_rate(char *buf, size_t size, double bps)
+{
+	static const char * const unit[] = { "B/s", "KiB/s", "MiB/s", "GiB/s" };
+	int u = 0;
+
+	while (bps >= 1024.0 && u < 3) {
+		bps /= 1024.0;
+		u++;
+	}
+	snprintf(buf, size, "%7.1f %-5s", bps, unit[u]);
+}
+
+static void out_append(const char *s, size_t len)
+{
+	if (scr.out_len + len > scr.out_size) {
+		size_t size = (scr.out_len + len) * 2;
+		char *out = realloc(scr.out, size);
+
+		if (!out)
+			return;
+		scr.out = out;
+		scr.out_size = size;
+	}
+	memcpy(scr.out + scr.out_len, s, len);
+	scr.out_len += len;
+}
+
+static void out_puts(const char *s)
+{
+	out_append(s, strlen(s));
+}
+
+static void out_flush(void)
+{
+	size_t done = 0;
+
+	while (done < scr.out_len) {
+		ssize_t ret = write(STDOUT_FILENO, scr.out + done,
+				    scr.out_len - done);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		done += ret;
+	}
+	scr.last_bytes = scr.out_len;
+	scr.out_len = 0;
+}
+
+static int screen_resize(void)
+{
+	struct winsize ws;
+	int rows = 24, cols = 80;
+	char *cur, *prev;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 &&
+	    ws.ws_row > 0 && ws.ws_col > 0) {
+		rows = ws.ws_row;
+		cols = ws.ws_col;
+	}
+
+	cur = malloc(rows * cols);
+	prev = malloc(rows * cols);
+	if (!cur || !prev) {
+		free(cur);
+		free(prev);
+		return -1;
+	}
+
+	free(scr.cur);
+	free(scr.prev);
+	scr.cur = cur;
+	scr.prev = prev;
+	scr.rows = rows;
+	scr.cols = cols;
+	scr.full = true;
+	return 0;
+}
+
+static void screen_put(int row, int col, const char *s)
+{
+	char *line;
+
+	if (row < 0 || row >= scr.rows)
+		return;
+
+	line = scr.cur + row * scr.cols;
+	for (; *s && col < scr.cols; s++, col++)
+		if (col >= 0)
+			line[col] = *s;
+}
+
+static void screen_printf(int row, int col, const char *fmt, ...)
+{
+	char buf[512];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	screen_put(row, col, buf);
+}
+
+static void screen_bar(int row, int col, int width, double fraction)
+{
+	char buf[256];
+	int i, n;
+
+	if (width > (int)sizeof(buf) - 3)
+		width = sizeof(buf) - 3;
+	if (fraction < 0.0)
+		fraction = 0.0;
+	if (fraction > 1.0)
+		fraction = 1.0;
+
+	n = fraction * width + 0.5;
+	buf[0] = '[';
+	for (i = 0; i < width; i++)
+		buf[i + 1] = i < n ? '#' : '.';
+	buf[width + 1] = ']';
+	buf[width + 2] = '\0';
+	screen_put(row, col, buf);
+}
+
+/* newest sample rightmost, scaled to max (or to the visible maximum) */
+static void screen_spark(int row, int col, int width,
+			 const struct history *h, float max)
+{
+	static const char ramp[] = " .:-=+*#%@";
+	char buf[512];
+	unsigned int i;
+	int n = width;
+
+	if (n > (int)sizeof(buf) - 1)
+		n = sizeof(buf) - 1;
+	if (n <= 0)
+		return;
+
+	if (max <= 0.0f) {
+		for (i = 0; i < h->len && (int)i < n; i++)
+			if (history_get(h, i) > max)
+				max = history_get(h, i);
+	}
+
+	memset(buf, ' ', n);
+	buf[n] = '\0';
+	for (i = 0; i < h->len && (int)i < n; i++) {
+		float v = history_get(h, i);
+		int level = 0;
+
+		if (max > 0.0f && v > 0.0f) {
+			level = 1 + v / max * (sizeof(ramp) - 3);
+			if (level > (int)sizeof(ramp) - 2)
+				level = sizeof(ramp) - 2;
+		}
+		buf[n - 1 - i] = ramp[level];
+	}
+	screen_put(row, col, buf);
+}
+
+static void screen_flush(void)
+{
+	char esc[32];
+	int row;
+
+	if (scr.full) {
+		out_puts("\033[H\033[2J");
+		memset(scr.prev, ' ', scr.rows * scr.cols);
+		scr.full = false;
+	}
+
+	for (row = 0; row < scr.rows; row++) {
+		const char *cur = scr.cur + row * scr.cols;
+		const char *prev = scr.prev + row * scr.cols;
+		int col = 0;
+
+		while (col < scr.cols) {
+			int start, end, gap;
+
+			if (cur[col] == prev[col]) {
+				col++;
+				continue;
+			}
+
+			start = col;
+			end = col;
+			for (gap = 0, col++; col < scr.cols && gap < RUN_GAP;
+			     col++) {
+				if (cur[col] != prev[col]) {
+					end = col;
+					gap = 0;
+				} else {
+					gap++;
+				}
+			}
+
+			snprintf(esc, sizeof(esc), "\033[%d;%dH", row + 1,
+				 start + 1);
+			out_puts(esc);
+			out_append(cur + start, end - start + 1);
+			col = end + 1;
+		}
+	}
+
+	memcpy(scr.prev, scr.cur, scr.rows * scr.cols);
+	if (scr.out_len)
+		out_flush();
+}
+
+static void render(void)
+{
+	char r[32], w[32], susp[32];
+	double max = 0.0;
+	unsigned int i;
+	int row = 0, c;
+	int spark = scr.cols - 9;
+
+	memset(scr.cur, ' ', scr.rows * scr.cols);
+
+	snprintf(susp, sizeof(susp), "  suspends %u", suspends);
+	screen_printf(row++, 0, "imx6_ddrstat  interval %g s  %s %s  window %u%s",
+		      interval / 1000.0, sweeping ? "sweep" : "filter",
+		      last.filter ? last.filter->name : "all", updates,
+		      suspends ? susp : "");
+	row++;
+
+	for (c = 0; c < 2; c++) {
+		const struct mmdc_stats *st = &last.mmdc[c];
+
+		if (!controller_seen[c])
+			continue;
+
+		format_rate(r, sizeof(r), perf_rate(&last, st->read_bytes));
+		format_rate(w, sizeof(w), perf_rate(&last, st->write_bytes));
+		screen_printf(row, 0, "MMDC%d %6.2f%% busy ", c, mmdc_busy(st));
+		screen_bar(row, 19, BAR_WIDTH, mmdc_busy(st) / 100.0);
+		screen_printf(row++, 19 + BAR_WIDTH + 3, "R %s W %s", r, w);
+		screen_put(row, 2, "busy");
+		screen_spark(row++, 8, spark, &busy[c], 100.0f);
+		screen_put(row, 2, "read");
+		screen_spark(row++, 8, spark, &rd[c], 0.0f);
+		screen_put(row, 2, "write");
+		screen_spark(row++, 8, spark, &wr[c], 0.0f);
+		row++;
+	}
+
+	for (i = 0; i < num_masters; i++)
+		if (masters[i].valid &&
+		    masters[i].read_bps + masters[i].write_bps > max)
+			max = masters[i].read_bps + masters[i].write_bps;
+
+	if (sweeping) {
+		screen_printf(row++, 0, "%-10s %-13s %-13s", "MASTER",
+			      "READ", "WRITE");
+		for (i = 0; i < num_masters && row < scr.rows - 1; i++) {
+			const struct master *m = &masters[i];
+
+			if (!m->valid)
+				continue;
+			format_rate(r, sizeof(r), m->read_bps);
+			format_rate(w, sizeof(w), m->write_bps);
+			screen_printf(row, 0, "%-10s %s %s", filters[i].name,
+				      r, w);
+			screen_bar(row++, 40, BAR_WIDTH, max > 0.0 ?
+				   (m->read_bps + m->write_bps) / max : 0.0);
+		}
+	}
+
+	screen_printf(scr.rows - 1, 0, "q quit  r redraw  last update %zu bytes",
+		      scr.last_bytes);
+}
+
+static void on_signal(int sig)
+{
+	if (sig == SIGWINCH) {
+		resized = 1;
+	} else {
+		quit = 1;
+		sinks_interrupt();
+	}
+}
+
+void dashboard_configure(unsigned int interval_ms, bool sweep)
+{
+	interval = interval_ms;
+	sweeping = sweep;
+}
+
+int dashboard_init(unsigned int interval_ms, bool sweep)
+{
+	struct sigaction sa;
+	struct termios t;
+	struct axi_filter *filter;
+
+	dashboard_configure(interval_ms, sweep);
+
+	for (filter = filters; filter->name != NULL; filter++)
+		num_masters++;
+	masters = calloc(num_masters, sizeof(*masters));
+	if (!masters || screen_resize())
+		return -1;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGWINCH, &sa, NULL);
+
+	if (tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+		t = saved_termios;
+		t.c_lflag &= ~(ICANON | ECHO);
+		t.c_cc[VMIN] = 0;
+		t.c_cc[VTIME] = 0;
+		raw = tcsetattr(STDIN_FILENO, TCSANOW, &t) == 0;
+	}
+
+	/* alternate screen, hide cursor */
+	out_puts("\033[?1049h\033[?25l");
+	render();
+	screen_flush();
+	return 0;
+}
+
+/*
+ * Sleep for the profiling interval while handling key presses and
+ * terminal resizes. Returns -1 if the user asked to quit.
+ */
+int dashboard_wait(unsigned int ms)
+{
+	struct timespec now, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	end.tv_sec += ms / 1000;
+	end.tv_nsec += (ms % 1000) * 1000000;
+	if (end.tv_nsec >= 1000000000) {
+		end.tv_sec++;
+		end.tv_nsec -= 1000000000;
+	}
+
+	for (;;) {
+		struct pollfd pfd = { .fd = input_fd, .events = POLLIN };
+		long timeout;
+		char key;
+
+		if (quit)
+			return -1;
+		if (resized) {
+			resized = 0;
+			if (screen_resize() == 0) {
+				render();
+				screen_flush();
+			}
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		timeout = (end.tv_sec - now.tv_sec) * 1000 +
+			  (end.tv_nsec - now.tv_nsec) / 1000000;
+		if (timeout <= 0)
+			return 0;
+
+		if (poll(&pfd, 1, timeout) <= 0 || !(pfd.revents & POLLIN))
+			continue;
+
+		if (read(input_fd, &key, 1) != 1) {
+			/* stdin closed, keep on sampling without input */
+			input_fd = -1;
+			continue;
+		}
+
+		switch (key) {
+		case 'q':
+		case 'Q':
+			return -1;
+		case 'r':
+		case 'R':
+		case '\f':
+			scr.full = true;
+			render();
+			screen_flush();
+			break;
+		}
+	}
+}
+
+void dashboard_update(const struct perf_sample *s)
+{
+	bool totals = sweeping ? s->filter == NULL : true;
+	int c;
+
+	updates++;
+	/* keep showing the last window that was fully awake */
+	if (s->suspended_ns) {
+		suspends++;
+		render();
+		screen_flush();
+		return;
+	}
+	last = *s;
+
+	for (c = 0; c < 2; c++) {
+		const struct mmdc_stats *st = &s->mmdc[c];
+
+		if (!st->cycles)
+			continue;
+		controller_seen[c] = true;
+		history_add(&busy[c], mmdc_busy(st));
+		if (totals) {
+			history_add(&rd[c], perf_rate(s, st->read_bytes));
+			history_add(&wr[c], perf_rate(s, st->write_bytes));
+		}
+	}
+
+	if (s->filter) {
+		struct master *m = &masters[s->filter - filters];
+
+		m->read_bps = perf_rate(s, s->mmdc[0].read_bytes +
+					s->mmdc[1].read_bytes);
+		m->write_bps = perf_rate(s, s->mmdc[0].write_bytes +
+					 s->mmdc[1].write_bytes);
+		m->valid = true;
+	}
+
+	render();
+	screen_flush();
+}
+
+void dashboard_exit(void)
+{
+	out_puts("\033[?25h\033[?1049l");
+	out_flush();
+	if (raw)
+		tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+	free(scr.cur);
+	free(scr.prev);
+	free(scr.out);
+	free(masters);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Admission control from the shell. Prints the load published by
+ * imx6_ddrstat --admit, or waits for headroom tokens and then runs a
+ * command, so batch jobs can be started with
+ *
+ *	ddrstat_admit -t 2 -w 60 -- convert big.png -resize 10% small.png
+ *
+ * Without a running imx6_ddrstat the command runs right away.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ddrstat_admit.h"
+
+static void usage(void)
+{
+	printf("Usage: ddrstat_admit [-n name] [-t tokens] [-w seconds] [command [args]]\n"
+	       "  -n name	shared memory name (default %s)\n"
+	       "  -t tokens	tokens to take before running command (default 1)\n"
+	       "  -w seconds	give up after this long (default 0, wait forever)\n"
+	       " Without a command, print the current load.\n",
+	       DDRSTAT_ADMIT_NAME);
+}
+
+static void print_status(struct ddrstat_admit *a)
+{
+	struct ddrstat_admit_status st;
+
+	ddrstat_admit_status(a, &st);
+	printf("window %u interval_ms %u busy %.2f%% smoothed %.2f%% limit %.2f%% tokens %u%s%s\n",
+	       st.window, st.interval_ms, st.busy, st.smoothed, st.limit,
+	       st.tokens, st.critical ? " critical" : "",
+	       st.stale ? " stale" : "");
+}
+
+int main(int argc, char **argv)
+{
+	struct ddrstat_admit *a;
+	const char *name = NULL;
+	unsigned int tokens = 1;
+	unsigned int timeout_s = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "+hn:t:w:")) != -1) {
+		switch (c) {
+		case 'n':
+			name = optarg;
+			break;
+		case 't':
+			tokens = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			timeout_s = strtoul(optarg, NULL, 0);
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	a = ddrstat_admit_open(name);
+	if (optind == argc) {
+		if (!a) {
+			fprintf(stderr, "no admission control segment\n");
+			return 1;
+		}
+		print_status(a);
+		ddrstat_admit_close(a);
+		return 0;
+	}
+
+	if (a) {
+		if (ddrstat_admit_wait(a, tokens, timeout_s * 1000)) {
+			fprintf(stderr, "not admitted within %u s\n",
+				timeout_s);
+			return 75;	/* EX_TEMPFAIL */
+		}
+		ddrstat_admit_close(a);
+	}
+
+	execvp(argv[optind], argv + optind);
+	perror(argv[optind]);
+	return 127;
+}
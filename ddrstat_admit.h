@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DDRSTAT_ADMIT_H
+#define DDRSTAT_ADMIT_H
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/*
+ * Bandwidth admission control for applications, published by
+ * imx6_ddrstat --admit. Background work (thumbnailing, unpacking an
+ * update) checks the DDR load before starting a memory heavy chunk and
+ * defers it while the bus is busy.
+ *
+ * After every window imx6_ddrstat updates the load under a sequence
+ * lock and refills a bucket of headroom tokens: one token for every
+ * token% of busy%, or the smoothed busy% if higher, below the limit. A
+ * critical window, busy% at or above the critical level, gets none.
+ * Tokens left over from a window are forfeit, so a process that takes
+ * some and dies does not leak them.
+ *
+ * This header is all a client needs. Reading the status and taking
+ * tokens are plain loads and atomics on the shared page, only opening
+ * the segment and ddrstat_admit_wait() enter the kernel.
+ *
+ *	struct ddrstat_admit *a = ddrstat_admit_open(NULL);
+ *
+ *	while (more_work()) {
+ *		if (a && ddrstat_admit_wait(a, 1, 5000) < 0)
+ *			continue;
+ *		do_chunk();
+ *	}
+ */
+
+#define DDRSTAT_ADMIT_MAGIC	0x4d444144	/* "DADM" */
+#define DDRSTAT_ADMIT_VERSION	1
+#define DDRSTAT_ADMIT_NAME	"/imx6_ddrstat_admit"
+
+/* the status is stale after this many intervals without a window */
+#define DDRSTAT_ADMIT_STALE	3
+
+struct ddrstat_admit {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t publisher_pid;	/* 0 once it exited */
+	uint32_t interval_ms;
+
+	uint32_t seq;		/* odd while the publisher writes */
+	uint32_t window;	/* bumped after every window, a futex */
+	uint32_t tokens;	/* left in this window */
+	uint32_t critical;
+
+	uint64_t updated_ns;	/* CLOCK_MONOTONIC */
+	double busy;		/* busy% of the last window */
+	double smoothed;	/* exponentially smoothed busy% */
+	double limit;
+	double token;		/* busy% per token */
+};
+
+struct ddrstat_admit_status {
+	uint32_t window;
+	uint32_t interval_ms;
+	uint32_t tokens;
+	bool critical;
+	bool stale;		/* the publisher stopped updating */
+	double busy;
+	double smoothed;
+	double limit;
+};
+
+/* Map the segment of a running imx6_ddrstat, NULL for the default name */
+static inline struct ddrstat_admit *ddrstat_admit_open(const char *name)
+{
+	struct ddrstat_admit *a;
+	int fd;
+
+	fd = shm_open(name ? name : DDRSTAT_ADMIT_NAME, O_RDWR, 0);
+	if (fd < 0)
+		return NULL;
+	a = (struct ddrstat_admit *)mmap(NULL, sizeof(*a),
+					 PROT_READ | PROT_WRITE, MAP_SHARED,
+					 fd, 0);
+	close(fd);
+	if (a == MAP_FAILED)
+		return NULL;
+	if (__atomic_load_n(&a->magic, __ATOMIC_ACQUIRE) != DDRSTAT_ADMIT_MAGIC ||
+	    a->version != DDRSTAT_ADMIT_VERSION) {
+		munmap(a, sizeof(*a));
+		return NULL;
+	}
+	return a;
+}
+
+static inline void ddrstat_admit_close(struct ddrstat_admit *a)
+{
+	munmap(a, sizeof(*a));
+}
+
+/* A consistent copy of the current load */
+static inline void ddrstat_admit_status(struct ddrstat_admit *a,
+					struct ddrstat_admit_status *st)
+{
+	struct timespec now;
+	uint64_t updated_ns;
+	uint32_t seq;
+
+	do {
+		while ((seq = __atomic_load_n(&a->seq, __ATOMIC_ACQUIRE)) & 1)
+			;
+		st->window = a->window;
+		st->interval_ms = a->interval_ms;
+		st->critical = a->critical;
+		st->busy = a->busy;
+		st->smoothed = a->smoothed;
+		st->limit = a->limit;
+		updated_ns = a->updated_ns;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&a->seq, __ATOMIC_RELAXED) != seq);
+	st->tokens = __atomic_load_n(&a->tokens, __ATOMIC_RELAXED);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	st->stale = !__atomic_load_n(&a->publisher_pid, __ATOMIC_RELAXED) ||
+		    (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec >
+		    updated_ns + (uint64_t)DDRSTAT_ADMIT_STALE *
+		    st->interval_ms * 1000000;
+}
+
+/*
+ * Take n tokens from the current window. False if there are not enough
+ * left; a stale segment admits everything, nobody is counting.
+ */
+static inline bool ddrstat_admit_take(struct ddrstat_admit *a, unsigned int n)
+{
+	struct ddrstat_admit_status st;
+	uint32_t tokens = __atomic_load_n(&a->tokens, __ATOMIC_RELAXED);
+
+	do {
+		if (tokens < n) {
+			ddrstat_admit_status(a, &st);
+			return st.stale;
+		}
+	} while (!__atomic_compare_exchange_n(&a->tokens, &tokens, tokens - n,
+					      true, __ATOMIC_ACQ_REL,
+					      __ATOMIC_RELAXED));
+	return true;
+}
+
+/*
+ * Take n tokens, sleeping through windows without enough of them.
+ * Returns 0 once admitted, -1 after timeout_ms (0 waits forever).
+ */
+static inline int ddrstat_admit_wait(struct ddrstat_admit *a, unsigned int n,
+				     unsigned int timeout_ms)
+{
+	struct timespec start, now, ts;
+	uint64_t left_ns, spent_ns;
+	uint32_t window;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (;;) {
+		window = __atomic_load_n(&a->window, __ATOMIC_ACQUIRE);
+		if (ddrstat_admit_take(a, n))
+			return 0;
+
+		/* also wake up to notice a publisher that went away */
+		left_ns = (uint64_t)DDRSTAT_ADMIT_STALE * 1000000 *
+			  (a->interval_ms ? a->interval_ms : 1000);
+		if (timeout_ms) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			spent_ns = (now.tv_sec - start.tv_sec) * 1000000000ull +
+				   now.tv_nsec - start.tv_nsec;
+			if (spent_ns >= timeout_ms * 1000000ull)
+				return -1;
+			if (timeout_ms * 1000000ull - spent_ns < left_ns)
+				left_ns = timeout_ms * 1000000ull - spent_ns;
+		}
+		ts.tv_sec = left_ns / 1000000000;
+		ts.tv_nsec = left_ns % 1000000000;
+		syscall(SYS_futex, &a->window, FUTEX_WAIT, window, &ts,
+			NULL, 0);
+	}
+}
+
+#endif
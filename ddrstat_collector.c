@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Host side collector for samples streamed by imx6_ddrstat --stream.
+ * Listens on the same port for TCP and UDP, timestamps every batch on
+ * arrival, appends the samples to one CSV file per device and keeps
+ * running per-device aggregates, printed periodically.
+ *
+ * Devices send a clock correlation record every now and then. The last
+ * two of them give the rate between the device's raw monotonic clock
+ * and its wall clock, which places every window start on the device's
+ * wall clock even between corrections, so windows from several boards
+ * can be lined up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "ddrstat_proto.h"
+
+#define MAX_CLIENTS	256
+
+struct client {
+	int fd;
+	uint8_t *buf;
+	size_t len;
+	size_t size;
+};
+
+struct device {
+	char name[DDRSTAT_DEVICE_LEN + 1];
+	FILE *out;
+	bool have_seq;
+	uint32_t next_seq;
+	uint64_t samples;
+	uint64_t lost;
+	uint64_t suspends;
+	uint32_t dropped;
+	uint64_t busy_samples;
+	double busy_sum;
+	double busy_max;
+	uint64_t total_ns;
+	uint64_t read_bytes;
+	uint64_t write_bytes;
+	struct timespec last_seen;
+	struct clock_corr corr[2];	/* previous and last correlation */
+	unsigned int num_corr;
+};
+
+static struct pollfd pfds[MAX_CLIENTS + 2];
+static struct client clients[MAX_CLIENTS];
+static unsigned int num_clients;
+
+static struct device *devices;
+static unsigned int num_devices;
+
+static const char *outdir;
+static volatile sig_atomic_t quit, dump;
+
+static void on_signal(int sig)
+{
+	if (sig == SIGUSR1)
+		dump = 1;
+	else
+		quit = 1;
+}
+
+static struct device *device_get(const char *name)
+{
+	struct device *dev;
+	char path[4096];
+	unsigned int i;
+	char *p;
+
+	for (i = 0; i < num_devices; i++)
+		if (strcmp(devices[i].name, name) == 0)
+			return &devices[i];
+
+	dev = realloc(devices, (num_devices + 1) * sizeof(*devices));
+	if (!dev)
+		return NULL;
+	devices = dev;
+	dev = &devices[num_devices++];
+	memset(dev, 0, sizeof(*dev));
+	snprintf(dev->name, sizeof(dev->name), "%s", name);
+
+	if (outdir) {
+		snprintf(path, sizeof(path), "%s/%s.csv", outdir, name);
+		/* device names come from the network, keep them in outdir */
+		for (p = path + strlen(outdir) + 1; *p; p++)
+			if (*p == '/')
+				*p = '_';
+		dev->out = fopen(path, "a");
+		if (!dev->out)
+			perror(path);
+		else
+			setvbuf(dev->out, NULL, _IOLBF, 0);
+	}
+
+	printf("new device '%s'\n", dev->name);
+	return dev;
+}
+
+/* Device wall clock time of a raw timestamp, 0 if it is not known yet */
+static uint64_t device_realtime(const struct device *dev, uint64_t raw_ns)
+{
+	const struct clock_corr *a = &dev->corr[0], *b = &dev->corr[1];
+	double rate = 1.0;
+
+	if (!dev->num_corr || !raw_ns)
+		return 0;
+	if (dev->num_corr > 1 && b->raw_ns > a->raw_ns)
+		rate = (double)(b->realtime_ns - a->realtime_ns) /
+		       (b->raw_ns - a->raw_ns);
+
+	return b->realtime_ns + (int64_t)(((double)raw_ns - b->raw_ns) * rate);
+}
+
+static void store_sample(struct device *dev, const struct timespec *ts,
+			 uint32_t seq, const struct perf_sample *s)
+{
+	const struct mmdc_stats *m0 = &s->mmdc[0], *m1 = &s->mmdc[1];
+	uint64_t start_rt;
+
+	if (s->has_corr) {
+		/* a rebooted device starts a new raw clock */
+		if (dev->num_corr && s->corr.raw_ns <= dev->corr[1].raw_ns)
+			dev->num_corr = 0;
+		dev->corr[0] = dev->num_corr ? dev->corr[1] : s->corr;
+		dev->corr[1] = s->corr;
+		if (dev->num_corr < 2)
+			dev->num_corr++;
+	}
+
+	dev->samples++;
+	if (s->suspended_ns) {
+		dev->suspends++;
+	} else if (m0->cycles) {
+		double busy = mmdc_busy(m0);
+
+		dev->busy_sum += busy;
+		dev->busy_samples++;
+		if (busy > dev->busy_max)
+			dev->busy_max = busy;
+	}
+	if (!s->filter && !s->suspended_ns) {
+		dev->total_ns += s->duration_ns;
+		dev->read_bytes += m0->read_bytes + m1->read_bytes;
+		dev->write_bytes += m0->write_bytes + m1->write_bytes;
+	}
+
+	if (!dev->out)
+		return;
+
+	fprintf(dev->out, "%ld.%09ld,%u,%llu,%s,"
+		"%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%llu,%llu,%llu,",
+		(long)ts->tv_sec, ts->tv_nsec, seq,
+		(unsigned long long)s->duration_ns,
+		s->filter ? s->filter->name : "all",
+		m0->cycles, m0->busy_cycles, m0->read_accesses,
+		m0->write_accesses, m0->read_bytes, m0->write_bytes,
+		m1->cycles, m1->busy_cycles, m1->read_accesses,
+		m1->write_accesses, m1->read_bytes, m1->write_bytes,
+		(unsigned long long)s->start_raw_ns,
+		(unsigned long long)s->end_raw_ns,
+		(unsigned long long)s->suspended_ns);
+	start_rt = device_realtime(dev, s->start_raw_ns);
+	if (start_rt)
+		fprintf(dev->out, "%llu.%09llu\n",
+			(unsigned long long)(start_rt / 1000000000),
+			(unsigned long long)(start_rt % 1000000000));
+	else
+		fprintf(dev->out, "\n");
+}
+
+/* Handle one batch, returns its size or 0 if it is not complete yet */
+static size_t handle_batch(const uint8_t *buf, size_t len, bool *bad)
+{
+	struct ddrstat_batch b;
+	struct perf_sample s;
+	struct device *dev;
+	struct timespec ts;
+	size_t size;
+	unsigned int i;
+
+	*bad = false;
+	if (len < DDRSTAT_HEADER_SIZE)
+		return 0;
+	if (ddrstat_get_header(buf, len, &b)) {
+		*bad = true;
+		return 0;
+	}
+
+	size = b.header_size + (size_t)b.count * b.sample_size;
+	if (len < size)
+		return 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	dev = device_get(b.device);
+	if (!dev)
+		return size;
+
+	if (dev->have_seq && b.seq != dev->next_seq) {
+		/* anything but a small step back means the device restarted */
+		if ((int32_t)(b.seq - dev->next_seq) > 0)
+			dev->lost += b.seq - dev->next_seq;
+	}
+	dev->have_seq = true;
+	dev->next_seq = b.seq + b.count;
+	dev->dropped = b.dropped;
+	dev->last_seen = ts;
+
+	for (i = 0; i < b.count; i++) {
+		ddrstat_get_sample(buf + b.header_size + i * b.sample_size,
+				   b.sample_size, &s);
+		store_sample(dev, &ts, b.seq + i, &s);
+	}
+
+	return size;
+}
+
+static void print_summary(void)
+{
+	struct timespec now;
+	unsigned int i;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	printf("%-20s %10s %8s %8s %8s %8s %8s %12s %12s %6s\n", "DEVICE",
+	       "SAMPLES", "LOST", "DROPPED", "SUSPENDS", "BUSY%", "MAX%",
+	       "READ MB/s", "WRITE MB/s", "AGE");
+	for (i = 0; i < num_devices; i++) {
+		struct device *dev = &devices[i];
+		double s = dev->total_ns * 1e-9;
+
+		printf("%-20s %10llu %8llu %8u %8llu %8.2f %8.2f %12.1f %12.1f %5lds\n",
+		       dev->name, (unsigned long long)dev->samples,
+		       (unsigned long long)dev->lost, dev->dropped,
+		       (unsigned long long)dev->suspends,
+		       dev->busy_samples ? dev->busy_sum / dev->busy_samples : 0.0,
+		       dev->busy_max,
+		       s > 0 ? dev->read_bytes / s / 1e6 : 0.0,
+		       s > 0 ? dev->write_bytes / s / 1e6 : 0.0,
+		       (long)(now.tv_sec - dev->last_seen.tv_sec));
+	}
+	fflush(stdout);
+}
+
+static int listen_socket(int type, const char *port)
+{
+	struct addrinfo hints, *res;
+	int one = 1;
+	int fd;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET6;
+	hints.ai_socktype = type;
+	hints.ai_flags = AI_PASSIVE;
+
+	if (getaddrinfo(NULL, port, &hints, &res)) {
+		hints.ai_family = AF_INET;
+		if (getaddrinfo(NULL, port, &hints, &res))
+			return -1;
+	}
+
+	fd = socket(res->ai_family, res->ai_socktype | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto out;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (bind(fd, res->ai_addr, res->ai_addrlen) < 0 ||
+	    (type == SOCK_STREAM && listen(fd, 16) < 0)) {
+		close(fd);
+		fd = -1;
+	}
+out:
+	freeaddrinfo(res);
+	return fd;
+}
+
+static void client_close(unsigned int i)
+{
+	close(clients[i].fd);
+	free(clients[i].buf);
+	clients[i] = clients[--num_clients];
+}
+
+static void client_read(unsigned int i)
+{
+	struct client *c = &clients[i];
+	size_t used = 0, size;
+	ssize_t ret;
+	bool bad;
+
+	if (c->size - c->len < DDRSTAT_MAX_FRAME) {
+		uint8_t *buf = realloc(c->buf, c->size + DDRSTAT_MAX_FRAME);
+
+		if (!buf) {
+			client_close(i);
+			return;
+		}
+		c->buf = buf;
+		c->size += DDRSTAT_MAX_FRAME;
+	}
+
+	ret = read(c->fd, c->buf + c->len, c->size - c->len);
+	if (ret <= 0) {
+		if (ret < 0 && errno == EINTR)
+			return;
+		client_close(i);
+		return;
+	}
+	c->len += ret;
+
+	while ((size = handle_batch(c->buf + used, c->len - used, &bad)))
+		used += size;
+	if (bad) {
+		fprintf(stderr, "garbage on stream, closing connection\n");
+		client_close(i);
+		return;
+	}
+	memmove(c->buf, c->buf + used, c->len - used);
+	c->len -= used;
+}
+
+static void usage(void)
+{
+	printf("Usage: ddrstat_collector [-p port] [-o dir] [-i seconds]\n"
+	       "  -p port	TCP and UDP port to listen on (default %d)\n"
+	       "  -o dir	append samples to dir/<device>.csv\n"
+	       "  -i seconds	summary interval, 0 disables (default 10)\n"
+	       " SIGUSR1 prints a summary immediately\n", DDRSTAT_PORT);
+}
+
+int main(int argc, char **argv)
+{
+	char port[16];
+	uint8_t dgram[65536];
+	struct sigaction sa;
+	struct timespec now, next;
+	int interval = 10;
+	int tcp, udp;
+	unsigned int i, n;
+	bool bad;
+	int c;
+
+	snprintf(port, sizeof(port), "%d", DDRSTAT_PORT);
+	while ((c = getopt(argc, argv, "p:o:i:")) != -1) {
+		switch (c) {
+		case 'p':
+			snprintf(port, sizeof(port), "%s", optarg);
+			break;
+		case 'o':
+			outdir = optarg;
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	tcp = listen_socket(SOCK_STREAM, port);
+	udp = listen_socket(SOCK_DGRAM, port);
+	if (tcp < 0 || udp < 0) {
+		fprintf(stderr, "cannot listen on port %s: %s\n", port,
+			strerror(errno));
+		return 1;
+	}
+	printf("listening on port %s\n", port);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGUSR1, &sa, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	next.tv_sec += interval;
+
+	while (!quit) {
+		int timeout = -1;
+
+		if (interval > 0) {
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			if (now.tv_sec >= next.tv_sec) {
+				print_summary();
+				next.tv_sec = now.tv_sec + interval;
+			}
+			timeout = (next.tv_sec - now.tv_sec) * 1000;
+		}
+		if (dump) {
+			dump = 0;
+			print_summary();
+		}
+
+		pfds[0].fd = tcp;
+		pfds[0].events = POLLIN;
+		pfds[1].fd = udp;
+		pfds[1].events = POLLIN;
+		for (i = 0; i < num_clients; i++) {
+			pfds[i + 2].fd = clients[i].fd;
+			pfds[i + 2].events = POLLIN;
+			pfds[i + 2].revents = 0;
+		}
+
+		n = num_clients;
+		if (poll(pfds, n + 2, timeout) <= 0)
+			continue;
+
+		if (pfds[0].revents & POLLIN) {
+			int fd = accept4(tcp, NULL, NULL, SOCK_CLOEXEC);
+
+			if (fd >= 0 && num_clients < MAX_CLIENTS) {
+				memset(&clients[num_clients], 0,
+				       sizeof(clients[0]));
+				clients[num_clients++].fd = fd;
+			} else if (fd >= 0) {
+				close(fd);
+			}
+		}
+
+		if (pfds[1].revents & POLLIN) {
+			ssize_t len = recv(udp, dgram, sizeof(dgram), 0);
+
+			if (len > 0)
+				handle_batch(dgram, len, &bad);
+		}
+
+		/* backwards, client_close() moves the last client into i */
+		for (i = n; i-- > 0;)
+			if (pfds[i + 2].revents & (POLLIN | POLLHUP | POLLERR))
+				client_read(i);
+	}
+
+	print_summary();
+	for (i = 0; i < num_devices; i++)
+		if (devices[i].out)
+			fclose(devices[i].out);
+	return 0;
+}
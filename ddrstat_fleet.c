@@ -0,0 +1,736 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Fleet aggregation service. Ingests sample streams from many
+ * imx6_ddrstat instances at once and keeps per-device and fleet wide
+ * quantile sketches of busy% and bandwidth.
+ *
+ * Every worker thread runs its own epoll loop on its own SO_REUSEPORT
+ * TCP and UDP sockets, so the kernel spreads devices across workers and
+ * the hot path takes no shared lock except the (uncontended) one of the
+ * device a batch belongs to. Fleet wide sketches are kept per worker and
+ * merged only when a summary is produced.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "ddrstat_proto.h"
+#include "sketch.h"
+
+#define MAX_EVENTS	64
+#define DEVICE_HASH	1024
+#define TOP_DEVICES	10
+
+enum metric {
+	METRIC_BUSY,
+	METRIC_READ,
+	METRIC_WRITE,
+	NUM_METRICS,
+};
+
+static const char * const metric_name[NUM_METRICS] = {
+	"busy %", "read MB/s", "write MB/s",
+};
+
+struct device {
+	struct device *next;
+	char name[DDRSTAT_DEVICE_LEN + 1];
+	pthread_mutex_t lock;
+	bool have_seq;
+	uint32_t next_seq;
+	uint64_t samples;
+	uint64_t lost;
+	uint32_t dropped;
+	time_t last_seen;
+	struct sketch metric[NUM_METRICS];
+};
+
+struct conn {
+	int fd;
+	uint8_t *buf;
+	size_t len;
+	size_t size;
+};
+
+struct worker {
+	pthread_t thread;
+	int epfd;
+	int tcp;
+	int udp;
+	pthread_mutex_t lock;
+	uint64_t samples;
+	uint64_t batches;
+	struct sketch metric[NUM_METRICS];
+	uint8_t dgram[65536];
+};
+
+static struct device *device_hash[DEVICE_HASH];
+static unsigned int num_devices;
+static pthread_rwlock_t device_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static struct worker *workers;
+static unsigned int num_workers;
+static char port[16];
+static int query = -1;
+static volatile sig_atomic_t quit, dump;
+
+static unsigned int hash(const char *s)
+{
+	unsigned int h = 5381;
+
+	while (*s)
+		h = h * 33 + (unsigned char)*s++;
+	return h % DEVICE_HASH;
+}
+
+static struct device *device_find(const char *name, unsigned int h)
+{
+	struct device *dev;
+
+	for (dev = device_hash[h]; dev; dev = dev->next)
+		if (strcmp(dev->name, name) == 0)
+			return dev;
+	return NULL;
+}
+
+static struct device *device_get(const char *name)
+{
+	unsigned int h = hash(name);
+	struct device *dev;
+	int i;
+
+	pthread_rwlock_rdlock(&device_lock);
+	dev = device_find(name, h);
+	pthread_rwlock_unlock(&device_lock);
+	if (dev)
+		return dev;
+
+	pthread_rwlock_wrlock(&device_lock);
+	dev = device_find(name, h);
+	if (!dev) {
+		dev = calloc(1, sizeof(*dev));
+		if (dev) {
+			snprintf(dev->name, sizeof(dev->name), "%s", name);
+			pthread_mutex_init(&dev->lock, NULL);
+			for (i = 0; i < NUM_METRICS; i++)
+				sketch_init(&dev->metric[i]);
+			dev->next = device_hash[h];
+			device_hash[h] = dev;
+			num_devices++;
+		}
+	}
+	pthread_rwlock_unlock(&device_lock);
+
+	return dev;
+}
+
+/* Per-sample metric values, valid[m] tells whether the sample has one */
+static void sample_metrics(const struct perf_sample *s, double *v, bool *valid)
+{
+	const struct mmdc_stats *m0 = &s->mmdc[0], *m1 = &s->mmdc[1];
+
+	/* report the busier controller on dual channel boards */
+	v[METRIC_BUSY] = fmax(mmdc_busy(m0), mmdc_busy(m1));
+	valid[METRIC_BUSY] = m0->cycles || m1->cycles;
+
+	/* filtered windows only see part of the traffic */
+	valid[METRIC_READ] = valid[METRIC_WRITE] = !s->filter;
+	v[METRIC_READ] = perf_rate(s, m0->read_bytes + m1->read_bytes) / 1e6;
+	v[METRIC_WRITE] = perf_rate(s, m0->write_bytes + m1->write_bytes) / 1e6;
+
+	/* nothing in a window that spanned a suspend can be trusted */
+	if (s->suspended_ns)
+		valid[METRIC_BUSY] = valid[METRIC_READ] =
+			valid[METRIC_WRITE] = false;
+}
+
+static size_t handle_batch(struct worker *w, const uint8_t *buf, size_t len,
+			   bool *bad)
+{
+	struct ddrstat_batch b;
+	struct perf_sample s;
+	struct device *dev;
+	double v[NUM_METRICS];
+	bool valid[NUM_METRICS];
+	size_t size;
+	unsigned int i;
+	int m;
+
+	*bad = false;
+	if (len < DDRSTAT_HEADER_SIZE)
+		return 0;
+	if (ddrstat_get_header(buf, len, &b)) {
+		*bad = true;
+		return 0;
+	}
+
+	size = b.header_size + (size_t)b.count * b.sample_size;
+	if (len < size)
+		return 0;
+
+	dev = device_get(b.device);
+	if (!dev)
+		return size;
+
+	pthread_mutex_lock(&dev->lock);
+	if (dev->have_seq && (int32_t)(b.seq - dev->next_seq) > 0)
+		dev->lost += b.seq - dev->next_seq;
+	dev->have_seq = true;
+	dev->next_seq = b.seq + b.count;
+	dev->dropped = b.dropped;
+	dev->last_seen = time(NULL);
+	dev->samples += b.count;
+	pthread_mutex_lock(&w->lock);
+	for (i = 0; i < b.count; i++) {
+		ddrstat_get_sample(buf + b.header_size + i * b.sample_size,
+				   b.sample_size, &s);
+		sample_metrics(&s, v, valid);
+		for (m = 0; m < NUM_METRICS; m++) {
+			if (!valid[m])
+				continue;
+			sketch_add(&dev->metric[m], v[m]);
+			sketch_add(&w->metric[m], v[m]);
+		}
+	}
+	w->samples += b.count;
+	w->batches++;
+	pthread_mutex_unlock(&w->lock);
+	pthread_mutex_unlock(&dev->lock);
+
+	return size;
+}
+
+static void conn_close(struct conn *c)
+{
+	close(c->fd);
+	free(c->buf);
+	free(c);
+}
+
+static void conn_read(struct worker *w, struct conn *c)
+{
+	size_t used = 0, size;
+	ssize_t ret;
+	bool bad;
+
+	if (c->size - c->len < DDRSTAT_MAX_FRAME) {
+		uint8_t *buf = realloc(c->buf, c->size + DDRSTAT_MAX_FRAME);
+
+		if (!buf) {
+			conn_close(c);
+			return;
+		}
+		c->buf = buf;
+		c->size += DDRSTAT_MAX_FRAME;
+	}
+
+	ret = read(c->fd, c->buf + c->len, c->size - c->len);
+	if (ret < 0 && (errno == EINTR || errno == EAGAIN))
+		return;
+	if (ret <= 0) {
+		conn_close(c);
+		return;
+	}
+	c->len += ret;
+
+	while ((size = handle_batch(w, c->buf + used, c->len - used, &bad)))
+		used += size;
+	if (bad) {
+		conn_close(c);
+		return;
+	}
+	memmove(c->buf, c->buf + used, c->len - used);
+	c->len -= used;
+}
+
+static int bind_socket(int type, const char *service, bool reuseport)
+{
+	struct addrinfo hints, *res;
+	int one = 1;
+	int fd;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = type;
+	hints.ai_flags = AI_PASSIVE;
+
+	if (getaddrinfo(NULL, service, &hints, &res))
+		return -1;
+
+	fd = socket(res->ai_family,
+		    res->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0)
+		goto out;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	if (reuseport)
+		setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+	if (bind(fd, res->ai_addr, res->ai_addrlen) < 0 ||
+	    (type == SOCK_STREAM && listen(fd, 128) < 0)) {
+		close(fd);
+		fd = -1;
+	}
+out:
+	freeaddrinfo(res);
+	return fd;
+}
+
+static void summary(FILE *f)
+{
+	struct sketch fleet[NUM_METRICS];
+	struct device *top[TOP_DEVICES];
+	double top_p99[TOP_DEVICES];
+	struct device *dev;
+	uint64_t samples = 0, batches = 0, lost = 0, dropped = 0;
+	unsigned int i, n = 0, devices;
+	int m;
+
+	for (m = 0; m < NUM_METRICS; m++)
+		sketch_init(&fleet[m]);
+	for (i = 0; i < num_workers; i++) {
+		pthread_mutex_lock(&workers[i].lock);
+		for (m = 0; m < NUM_METRICS; m++)
+			sketch_merge(&fleet[m], &workers[i].metric[m]);
+		samples += workers[i].samples;
+		batches += workers[i].batches;
+		pthread_mutex_unlock(&workers[i].lock);
+	}
+
+	pthread_rwlock_rdlock(&device_lock);
+	devices = num_devices;
+	for (i = 0; i < DEVICE_HASH; i++) {
+		for (dev = device_hash[i]; dev; dev = dev->next) {
+			double p99;
+			unsigned int j;
+
+			pthread_mutex_lock(&dev->lock);
+			lost += dev->lost;
+			dropped += dev->dropped;
+			p99 = sketch_quantile(&dev->metric[METRIC_BUSY], 0.99);
+			pthread_mutex_unlock(&dev->lock);
+
+			/* insertion into the short list of busiest devices */
+			for (j = n; j > 0 && top_p99[j - 1] < p99; j--) {
+				if (j < TOP_DEVICES) {
+					top[j] = top[j - 1];
+					top_p99[j] = top_p99[j - 1];
+				}
+			}
+			if (j < TOP_DEVICES) {
+				top[j] = dev;
+				top_p99[j] = p99;
+				if (n < TOP_DEVICES)
+					n++;
+			}
+		}
+	}
+
+	fprintf(f, "fleet: %u devices, %llu samples in %llu batches, %llu lost, %llu dropped on devices\n",
+		devices, (unsigned long long)samples,
+		(unsigned long long)batches, (unsigned long long)lost,
+		(unsigned long long)dropped);
+	fprintf(f, "%-12s %10s %10s %10s %10s %10s %10s\n", "METRIC", "MIN",
+		"P50", "P90", "P99", "MAX", "MEAN");
+	for (m = 0; m < NUM_METRICS; m++) {
+		const struct sketch *s = &fleet[m];
+
+		fprintf(f, "%-12s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+			metric_name[m], sketch_quantile(s, 0.0),
+			sketch_quantile(s, 0.5), sketch_quantile(s, 0.9),
+			sketch_quantile(s, 0.99), sketch_quantile(s, 1.0),
+			s->count ? s->sum / s->count : 0.0);
+	}
+
+	if (n)
+		fprintf(f, "busiest devices by p99 busy%%:\n%-20s %10s %10s %10s %10s %10s\n",
+			"DEVICE", "P50", "P99", "MAX", "SAMPLES", "LOST");
+	for (i = 0; i < n; i++) {
+		const struct sketch *s;
+
+		dev = top[i];
+		pthread_mutex_lock(&dev->lock);
+		s = &dev->metric[METRIC_BUSY];
+		fprintf(f, "%-20s %10.2f %10.2f %10.2f %10llu %10llu\n",
+			dev->name, sketch_quantile(s, 0.5),
+			sketch_quantile(s, 0.99), sketch_quantile(s, 1.0),
+			(unsigned long long)dev->samples,
+			(unsigned long long)dev->lost);
+		pthread_mutex_unlock(&dev->lock);
+	}
+	pthread_rwlock_unlock(&device_lock);
+	fflush(f);
+}
+
+static void query_reply(int fd)
+{
+	FILE *f = fdopen(fd, "w");
+
+	if (!f) {
+		close(fd);
+		return;
+	}
+	summary(f);
+	fclose(f);
+}
+
+static void *worker_thread(void *arg)
+{
+	struct worker *w = arg;
+	struct epoll_event ev[MAX_EVENTS];
+	bool bad;
+	int i, n;
+
+	while (!quit) {
+		n = epoll_wait(w->epfd, ev, MAX_EVENTS, 200);
+
+		for (i = 0; i < n; i++) {
+			void *ptr = ev[i].data.ptr;
+
+			if (ptr == &w->tcp) {
+				struct epoll_event e = { .events = EPOLLIN };
+				struct conn *c;
+				int fd = accept4(w->tcp, NULL, NULL,
+						 SOCK_CLOEXEC | SOCK_NONBLOCK);
+
+				if (fd < 0)
+					continue;
+				c = calloc(1, sizeof(*c));
+				if (!c) {
+					close(fd);
+					continue;
+				}
+				c->fd = fd;
+				e.data.ptr = c;
+				if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &e))
+					conn_close(c);
+			} else if (ptr == &w->udp) {
+				ssize_t len;
+
+				while ((len = recv(w->udp, w->dgram,
+						   sizeof(w->dgram), 0)) > 0)
+					handle_batch(w, w->dgram, len, &bad);
+			} else if (ptr == &query) {
+				int fd = accept4(query, NULL, NULL,
+						 SOCK_CLOEXEC);
+
+				if (fd >= 0)
+					query_reply(fd);
+			} else {
+				/* closing the fd also removes it from epoll */
+				conn_read(w, ptr);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static int worker_init(struct worker *w, bool first)
+{
+	struct epoll_event e = { .events = EPOLLIN };
+	int m;
+
+	pthread_mutex_init(&w->lock, NULL);
+	for (m = 0; m < NUM_METRICS; m++)
+		sketch_init(&w->metric[m]);
+
+	w->epfd = epoll_create1(EPOLL_CLOEXEC);
+	w->tcp = bind_socket(SOCK_STREAM, port, true);
+	w->udp = bind_socket(SOCK_DGRAM, port, true);
+	if (w->epfd < 0 || w->tcp < 0 || w->udp < 0)
+		return -1;
+
+	e.data.ptr = &w->tcp;
+	epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->tcp, &e);
+	e.data.ptr = &w->udp;
+	epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->udp, &e);
+	if (first && query >= 0) {
+		e.data.ptr = &query;
+		epoll_ctl(w->epfd, EPOLL_CTL_ADD, query, &e);
+	}
+
+	return 0;
+}
+
+/*
+ * Simulated devices, for trying the service without a test farm. Each
+ * one opens its own connection and streams synthetic samples at the
+ * given rate, with its own base load so the fleet has a spread.
+ */
+struct simdev {
+	char name[DDRSTAT_DEVICE_LEN + 1];
+	int fd;
+	uint32_t seq;
+	unsigned int seed;
+	double base;
+	double period;
+	double pending;
+};
+
+static unsigned int sim_devices;
+static double sim_rate = 10.0;
+static bool sim_udp;
+
+static void sim_sample(struct simdev *d, double t, struct perf_sample *s)
+{
+	double busy, noise = rand_r(&d->seed) * 2.0 / RAND_MAX - 1.0;
+	struct mmdc_stats *st = &s->mmdc[0];
+
+	memset(s, 0, sizeof(*s));
+	s->duration_ns = 1e9 / sim_rate;
+	busy = d->base * (1.0 + 0.3 * sin(2 * M_PI * t / d->period)) +
+	       5.0 * noise;
+	busy = fmin(fmax(busy, 0.0), 100.0);
+
+	st->cycles = 528e6 / sim_rate;
+	st->busy_cycles = st->cycles * busy / 100.0;
+	st->read_bytes = st->busy_cycles * 7.0;
+	st->write_bytes = st->busy_cycles * 3.0;
+	st->read_accesses = st->read_bytes / 48;
+	st->write_accesses = st->write_bytes / 32;
+}
+
+static int sim_connect(struct simdev *d)
+{
+	struct sockaddr_in sin = {
+		.sin_family = AF_INET,
+		.sin_port = htons(atoi(port)),
+		.sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+	};
+
+	d->fd = socket(AF_INET, (sim_udp ? SOCK_DGRAM : SOCK_STREAM) |
+		       SOCK_CLOEXEC, 0);
+	if (d->fd < 0)
+		return -1;
+	if (connect(d->fd, (struct sockaddr *)&sin, sizeof(sin)) < 0) {
+		close(d->fd);
+		d->fd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+static void *sim_thread(void *arg)
+{
+	struct timespec tick = { .tv_nsec = 100000000 };
+	uint8_t buf[DDRSTAT_MAX_FRAME];
+	struct ddrstat_batch b = { 0 };
+	struct perf_sample s;
+	struct simdev *devs;
+	unsigned int i, n;
+	double t = 0.0;
+	size_t len;
+
+	(void)arg;
+	devs = calloc(sim_devices, sizeof(*devs));
+	if (!devs)
+		return NULL;
+
+	for (i = 0; i < sim_devices; i++) {
+		struct simdev *d = &devs[i];
+
+		snprintf(d->name, sizeof(d->name), "sim-%04u", i);
+		d->seed = i + 1;
+		d->base = 10.0 + 50.0 * rand_r(&d->seed) / RAND_MAX;
+		d->period = 5.0 + 30.0 * rand_r(&d->seed) / RAND_MAX;
+		d->fd = -1;
+	}
+
+	while (!quit) {
+		nanosleep(&tick, NULL);
+		t += 0.1;
+
+		for (i = 0; i < sim_devices; i++) {
+			struct simdev *d = &devs[i];
+
+			if (d->fd < 0 && sim_connect(d) < 0)
+				continue;
+
+			d->pending += sim_rate * 0.1;
+			while (d->pending >= 1.0) {
+				n = d->pending > DDRSTAT_MAX_BATCH ?
+				    DDRSTAT_MAX_BATCH : d->pending;
+				snprintf(b.device, sizeof(b.device), "%s",
+					 d->name);
+				b.seq = d->seq;
+				b.count = n;
+				len = ddrstat_put_header(buf, &b);
+				for (; n; n--) {
+					sim_sample(d, t, &s);
+					len += ddrstat_put_sample(buf + len, &s);
+				}
+				d->seq += b.count;
+				d->pending -= b.count;
+
+				if (send(d->fd, buf, len, MSG_NOSIGNAL) !=
+				    (ssize_t)len) {
+					close(d->fd);
+					d->fd = -1;
+					break;
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < sim_devices; i++)
+		if (devs[i].fd >= 0)
+			close(devs[i].fd);
+	free(devs);
+	return NULL;
+}
+
+static void on_signal(int sig)
+{
+	if (sig == SIGUSR1)
+		dump = 1;
+	else
+		quit = 1;
+}
+
+static void usage(void)
+{
+	printf("Usage: ddrstat_fleet [-p port] [-j threads] [-i seconds] [-q port]\n"
+	       "                     [-s devices [-r rate] [-u]]\n"
+	       "  -p port	TCP and UDP port for device streams (default %d)\n"
+	       "  -j threads	worker threads (default: one per core)\n"
+	       "  -i seconds	summary interval, 0 disables (default 10)\n"
+	       "  -q port	serve the summary as text on this TCP port\n"
+	       "  -s devices	simulate this many devices on loopback\n"
+	       "  -r rate	samples per second per simulated device (10)\n"
+	       "  -u		simulated devices stream over UDP\n"
+	       " SIGUSR1 prints a summary immediately\n", DDRSTAT_PORT);
+}
+
+int main(int argc, char **argv)
+{
+	struct timespec tick = { .tv_nsec = 100000000 };
+	const char *query_port = NULL;
+	struct sigaction sa;
+	pthread_t sim;
+	time_t next;
+	int interval = 10;
+	unsigned int i;
+	int c;
+
+	snprintf(port, sizeof(port), "%d", DDRSTAT_PORT);
+	num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((c = getopt(argc, argv, "p:j:i:q:s:r:u")) != -1) {
+		switch (c) {
+		case 'p':
+			snprintf(port, sizeof(port), "%s", optarg);
+			break;
+		case 'j':
+			num_workers = atoi(optarg);
+			break;
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		case 'q':
+			query_port = optarg;
+			break;
+		case 's':
+			sim_devices = atoi(optarg);
+			break;
+		case 'r':
+			sim_rate = atof(optarg);
+			break;
+		case 'u':
+			sim_udp = true;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (num_workers < 1)
+		num_workers = 1;
+	if (sim_rate <= 0.0)
+		sim_rate = 10.0;
+
+	if (query_port) {
+		query = bind_socket(SOCK_STREAM, query_port, false);
+		if (query < 0) {
+			fprintf(stderr, "cannot listen on port %s\n",
+				query_port);
+			return 1;
+		}
+	}
+
+	workers = calloc(num_workers, sizeof(*workers));
+	if (!workers)
+		return 1;
+	for (i = 0; i < num_workers; i++) {
+		if (worker_init(&workers[i], i == 0)) {
+			fprintf(stderr, "cannot listen on port %s: %s\n",
+				port, strerror(errno));
+			return 1;
+		}
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	sigaction(SIGUSR1, &sa, NULL);
+	signal(SIGPIPE, SIG_IGN);
+
+	for (i = 0; i < num_workers; i++)
+		pthread_create(&workers[i].thread, NULL, worker_thread,
+			       &workers[i]);
+	if (sim_devices)
+		pthread_create(&sim, NULL, sim_thread, NULL);
+	printf("listening on port %s with %u workers\n", port, num_workers);
+	fflush(stdout);
+
+	next = time(NULL) + interval;
+	while (!quit) {
+		nanosleep(&tick, NULL);
+		if (dump || (interval > 0 && time(NULL) >= next)) {
+			dump = 0;
+			next = time(NULL) + interval;
+			summary(stdout);
+		}
+	}
+
+	if (sim_devices)
+		pthread_join(sim, NULL);
+	for (i = 0; i < num_workers; i++)
+		pthread_join(workers[i].thread, NULL);
+	summary(stdout);
+	return 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Minimal privileged sampler. Maps the two MMDC register pages, creates
+ * the shared memory ring and then drops every privilege: root becomes
+ * an unprivileged user, supplementary groups are cleared, no new
+ * privileges can be gained and the process is made non-dumpable so the
+ * register mapping cannot be reached through ptrace. From then on it
+ * only counts windows and publishes them; all parsing, formatting and
+ * analysis happens in imx6_ddrstat --shm running as an ordinary user.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/mman.h>
+
+#include "ddrstat_shm.h"
+
+#define SUSPEND_SLACK_NS	50000000
+/* the 32 bit cycle counter wraps after about 8 s at 528 MHz */
+#define HELPER_MAX_MS		4000
+
+static void *mmdc[2];
+static bool simulate;
+static volatile sig_atomic_t quit;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	quit = 1;
+}
+
+static uint64_t clock_ns(clockid_t clock)
+{
+	struct timespec ts;
+
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void set_filter(const struct axi_filter *filter)
+{
+	int c;
+
+	for (c = 0; c < 2; c++)
+		mmdc_set_filter(mmdc[c], filter ? filter->axi_id : 0,
+				filter ? filter->axi_id_mask : 0);
+}
+
+static int drop_privileges(uid_t uid, gid_t gid)
+{
+	if (geteuid() == 0) {
+		if (setgroups(0, NULL) || setgid(gid) || setuid(uid))
+			return -1;
+		/* make sure there is no way back */
+		if (uid != 0 && setuid(0) == 0)
+			return -1;
+	}
+	if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) ||
+	    prctl(PR_SET_DUMPABLE, 0, 0, 0, 0))
+		return -1;
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("Usage: ddrstat_helper [-S] [-u user] [-g group] [-i ms] [-n name]\n"
+	       "  -S		use a simulated MMDC instead of /dev/mem\n"
+	       "  -u user	run as this user after setup (default nobody)\n"
+	       "  -g group	group allowed to read the samples (default\n"
+	       "		the user's group)\n"
+	       "  -i ms		initial window length, 1-4000 (default 1000)\n"
+	       "  -n name	shared memory name (default %s)\n",
+	       DDRSTAT_SHM_NAME);
+}
+
+int main(int argc, char **argv)
+{
+	const char *user = "nobody", *group = NULL;
+	const char *name = DDRSTAT_SHM_NAME;
+	const struct axi_filter *filter = NULL;
+	unsigned int interval_ms = 1000, nfilters;
+	struct ddrstat_shm *shm;
+	struct perf_sample s;
+	struct sigaction sa;
+	struct timespec ts;
+	struct passwd *pw;
+	struct group *gr;
+	uint32_t seq;
+	int64_t slept;
+	bool overflow;
+	uid_t uid;
+	gid_t gid;
+	int fd = -1, c, opt;
+
+	while ((opt = getopt(argc, argv, "Su:g:i:n:h")) != -1) {
+		switch (opt) {
+		case 'S':
+			simulate = true;
+			break;
+		case 'u':
+			user = optarg;
+			break;
+		case 'g':
+			group = optarg;
+			break;
+		case 'i':
+			interval_ms = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			name = optarg;
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+	if (!interval_ms || interval_ms > HELPER_MAX_MS) {
+		fprintf(stderr, "interval must be 1-%u ms\n", HELPER_MAX_MS);
+		return 1;
+	}
+
+	pw = getpwnam(user);
+	if (!pw) {
+		fprintf(stderr, "unknown user '%s'\n", user);
+		return 1;
+	}
+	uid = pw->pw_uid;
+	gid = pw->pw_gid;
+	if (group) {
+		gr = getgrnam(group);
+		if (!gr) {
+			fprintf(stderr, "unknown group '%s'\n", group);
+			return 1;
+		}
+		gid = gr->gr_gid;
+	}
+	/* an unprivileged helper (simulation) keeps its own identity */
+	if (geteuid() != 0) {
+		uid = geteuid();
+		if (!group)
+			gid = getegid();
+	}
+
+	if (!simulate) {
+		fd = open("/dev/mem", O_RDWR | O_CLOEXEC);
+		if (fd < 0) {
+			perror("/dev/mem");
+			return 1;
+		}
+	}
+	mmdc[0] = mmdc_map(fd, MMDC0_BASE, simulate);
+	mmdc[1] = mmdc_map(fd, MMDC1_BASE, simulate);
+	if (fd >= 0)
+		close(fd);
+	if (!mmdc[0] || !mmdc[1]) {
+		perror("mmap");
+		return 1;
+	}
+	for (c = 0; c < 2; c++)
+		mmdc_arm(mmdc[c], 0, 0);
+
+	shm = ddrstat_shm_create(name, uid, gid);
+	if (!shm) {
+		perror(name);
+		return 1;
+	}
+	shm->interval_ms = interval_ms;
+
+	if (drop_privileges(uid, gid)) {
+		perror("dropping privileges");
+		shm_unlink(name);
+		return 1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	for (nfilters = 0; filters[nfilters].name; nfilters++)
+		;
+	seq = shm->req_seq;
+
+	while (!quit) {
+		memset(&s, 0, sizeof(s));
+		s.start_raw_ns = clock_ns(CLOCK_MONOTONIC_RAW);
+		s.start_boot_ns = clock_ns(CLOCK_BOOTTIME);
+		for (c = 0; c < 2; c++)
+			mmdc_start(mmdc[c], simulate);
+
+		ts.tv_sec = interval_ms / 1000;
+		ts.tv_nsec = (interval_ms % 1000) * 1000000;
+		while (nanosleep(&ts, &ts) && errno == EINTR && !quit)
+			;
+
+		s.end_raw_ns = clock_ns(CLOCK_MONOTONIC_RAW);
+		s.end_boot_ns = clock_ns(CLOCK_BOOTTIME);
+		overflow = false;
+		for (c = 0; c < 2; c++)
+			overflow |= mmdc_stop(mmdc[c], simulate, &s.mmdc[c]);
+		s.duration_ns = s.end_raw_ns - s.start_raw_ns;
+		s.filter = filter;
+
+		/* the MMDC comes back from suspend without profiling set up */
+		slept = (int64_t)(s.end_boot_ns - s.start_boot_ns) -
+			(int64_t)s.duration_ns;
+		if (slept > SUSPEND_SLACK_NS) {
+			s.suspended_ns = slept;
+			for (c = 0; c < 2; c++)
+				mmdc_arm(mmdc[c], 0, 0);
+			set_filter(filter);
+		}
+
+		/* wrapped counts would pass for a quiet window */
+		if (overflow && !s.suspended_ns)
+			fprintf(stderr, "cycle counter overflow, window dropped\n");
+		else
+			ddrstat_shm_publish(shm, &s);
+
+		/* requests come from unprivileged users, check everything */
+		if (__atomic_load_n(&shm->req_seq, __ATOMIC_ACQUIRE) != seq) {
+			int32_t f = shm->req_filter;
+			uint32_t ms = shm->req_interval_ms;
+
+			seq = shm->req_seq;
+			if (f >= -1 && f < (int32_t)nfilters) {
+				filter = f < 0 ? NULL : &filters[f];
+				set_filter(filter);
+			}
+			if (ms && ms <= HELPER_MAX_MS) {
+				interval_ms = ms;
+				shm->interval_ms = ms;
+			}
+			__atomic_store_n(&shm->ack_seq, seq, __ATOMIC_RELEASE);
+		}
+	}
+
+	shm_unlink(name);
+	ddrstat_shm_close(shm);
+	for (c = 0; c < 2; c++)
+		mmdc_unmap(mmdc[c], simulate);
+	return 0;
+}
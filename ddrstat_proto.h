@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DDRSTAT_PROTO_H
+#define DDRSTAT_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imx6_ddrstat.h"
+
+/*
+ * Wire format of streamed samples. Everything is little endian. A batch
+ * is a header followed by count samples, sent as one datagram over UDP
+ * or back to back over TCP. header_size and sample_size allow receivers
+ * to skip fields appended by newer senders.
+ *
+ * header:  u32 magic, u16 version, u16 count, u16 header_size,
+ *          u16 sample_size, u32 seq (of the first sample), u32 dropped,
+ *          char device[32]
+ * sample:  u64 duration_ns, u16 axi_id, u16 axi_id_mask, u32 flags,
+ *          u32 mmdc0[6], u32 mmdc1[6],
+ *          (version 2) u64 start_raw_ns, u64 end_raw_ns, u64 start_boot_ns,
+ *          u64 end_boot_ns, u64 corr_realtime_ns, u64 corr_raw_ns,
+ *          u64 corr_boot_ns, u32 corr_uncertainty_ns, u32 reserved
+ *
+ * The corr_ fields are only valid with DDRSTAT_FLAG_CORR set. Windows
+ * with DDRSTAT_FLAG_SUSPENDED spanned a system suspend, the time spent
+ * suspended is the boottime duration minus the raw duration.
+ */
+
+#define DDRSTAT_MAGIC		0x53524444	/* "DDRS" */
+#define DDRSTAT_VERSION		2
+#define DDRSTAT_PORT		7436
+
+#define DDRSTAT_DEVICE_LEN	32
+#define DDRSTAT_HEADER_SIZE	52
+#define DDRSTAT_SAMPLE_SIZE	128
+/* version 1 samples stop after the counters */
+#define DDRSTAT_SAMPLE_SIZE_V1	64
+
+/* keeps a full UDP batch below a 1500 byte MTU */
+#define DDRSTAT_MAX_BATCH	11
+#define DDRSTAT_MAX_FRAME	(DDRSTAT_HEADER_SIZE + \
+				 DDRSTAT_MAX_BATCH * DDRSTAT_SAMPLE_SIZE)
+
+#define DDRSTAT_FLAG_FILTERED	(1 << 0)
+#define DDRSTAT_FLAG_CORR	(1 << 1)
+#define DDRSTAT_FLAG_SWEEP	(1 << 2)
+#define DDRSTAT_FLAG_SUSPENDED	(1 << 3)
+
+struct ddrstat_batch {
+	uint16_t version;
+	uint16_t count;
+	uint16_t header_size;
+	uint16_t sample_size;
+	uint32_t seq;
+	uint32_t dropped;
+	char device[DDRSTAT_DEVICE_LEN + 1];
+};
+
+size_t ddrstat_put_header(uint8_t *buf, const struct ddrstat_batch *b);
+int ddrstat_get_header(const uint8_t *buf, size_t len,
+		       struct ddrstat_batch *b);
+size_t ddrstat_put_sample(uint8_t *buf, const struct perf_sample *s);
+void ddrstat_get_sample(const uint8_t *buf, size_t size,
+			struct perf_sample *s);
+
+#endif
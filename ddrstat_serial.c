@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Host side decoder for imx6_ddrstat --sink=serial. Reads console
+ * output from a tty (or a capture file), picks out the framed lines,
+ * drops those that fail the CRC and writes the windows as a binary
+ * recording, which imx6_ddrstat --replay turns into any other format.
+ * Everything else on the console is ignored, so a corrupted line only
+ * costs that one window.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ddrstat_proto.h"
+#include "ddrstat_serial.h"
+
+static const struct {
+	unsigned int baud;
+	speed_t speed;
+} speeds[] = {
+	{ 9600, B9600 },
+	{ 19200, B19200 },
+	{ 38400, B38400 },
+	{ 57600, B57600 },
+	{ 115200, B115200 },
+	{ 230400, B230400 },
+	{ 460800, B460800 },
+	{ 921600, B921600 },
+	{ 1500000, B1500000 },
+	{ 3000000, B3000000 },
+};
+
+static volatile sig_atomic_t quit;
+static char device[DDRSTAT_DEVICE_LEN + 1] = "serial";
+static FILE *out;
+
+static bool have_seq;
+static uint32_t next_seq;
+static uint64_t windows, corrupt, lost;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	quit = 1;
+}
+
+static int tty_setup(int fd, unsigned int baud)
+{
+	struct termios tio;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(speeds); i++)
+		if (speeds[i].baud == baud)
+			break;
+	if (i == ARRAY_SIZE(speeds)) {
+		fprintf(stderr, "unsupported baud rate %u\n", baud);
+		return -1;
+	}
+
+	if (tcgetattr(fd, &tio))
+		return -1;
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	cfsetispeed(&tio, speeds[i].speed);
+	cfsetospeed(&tio, speeds[i].speed);
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+/* Write one window as a single sample batch of a binary recording */
+static int write_sample(uint32_t seq, const struct perf_sample *s)
+{
+	uint8_t buf[DDRSTAT_HEADER_SIZE + DDRSTAT_SAMPLE_SIZE];
+	struct ddrstat_batch b = { 0 };
+	size_t len;
+
+	snprintf(b.device, sizeof(b.device), "%s", device);
+	b.seq = seq;
+	b.count = 1;
+	b.dropped = lost;
+	len = ddrstat_put_header(buf, &b);
+	len += ddrstat_put_sample(buf + len, s);
+	if (fwrite(buf, len, 1, out) != 1 || fflush(out))
+		return -1;
+	return 0;
+}
+
+/*
+ * Lines without a marker are console noise. A line with several markers
+ * lost a newline, each of its frames may still be intact.
+ */
+static int handle_line(const char *line)
+{
+	struct perf_sample s;
+	const char *p;
+	uint32_t seq;
+
+	for (p = strstr(line, DDRSTAT_SERIAL_MARKER); p;
+	     p = strstr(p + 2, DDRSTAT_SERIAL_MARKER)) {
+		if (serial_decode(p, &seq, &s)) {
+			corrupt++;
+			continue;
+		}
+
+		/* a restarted sender begins again at 0 */
+		if (have_seq && seq > next_seq)
+			lost += seq - next_seq;
+		have_seq = true;
+		next_seq = seq + 1;
+		windows++;
+
+		if (write_sample(seq, &s))
+			return -1;
+	}
+	return 0;
+}
+
+static void usage(void)
+{
+	printf("Usage: ddrstat_serial [-b baud] [-n device] [-o file] [tty|file]\n"
+	       "  -b baud	tty speed (default 115200)\n"
+	       "  -n device	device name in the recording (default serial)\n"
+	       "  -o file	write the recording to file (default stdout)\n"
+	       " reads stdin without a tty or file\n");
+}
+
+int main(int argc, char **argv)
+{
+	char line[4 * DDRSTAT_SERIAL_LINE];
+	unsigned int baud = 115200;
+	const char *output = NULL;
+	struct sigaction sa;
+	size_t len = 0;
+	bool skip = false;
+	char buf[4096];
+	ssize_t n, i;
+	int fd = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "b:n:o:")) != -1) {
+		switch (c) {
+		case 'b':
+			baud = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			snprintf(device, sizeof(device), "%s", optarg);
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	if (optind < argc) {
+		fd = open(argv[optind], O_RDONLY | O_NOCTTY);
+		if (fd < 0) {
+			perror(argv[optind]);
+			return 1;
+		}
+	}
+	if (isatty(fd) && tty_setup(fd, baud)) {
+		perror("tty");
+		return 1;
+	}
+
+	out = output ? fopen(output, "w") : stdout;
+	if (!out) {
+		perror(output);
+		return 1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = on_signal;
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	while (!quit) {
+		n = read(fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+
+		for (i = 0; i < n; i++) {
+			if (buf[i] == '\n' || buf[i] == '\r') {
+				line[len] = '\0';
+				if (!skip && len && handle_line(line)) {
+					perror("write");
+					return 1;
+				}
+				len = 0;
+				skip = false;
+			} else if (len == sizeof(line) - 1) {
+				/* garbage without newlines, resync on the next */
+				line[len] = '\0';
+				if (!skip && strstr(line, DDRSTAT_SERIAL_MARKER))
+					corrupt++;
+				skip = true;
+			} else if (!skip) {
+				line[len++] = buf[i];
+			}
+		}
+	}
+
+	if (len && !skip) {
+		line[len] = '\0';
+		handle_line(line);
+	}
+
+	fprintf(stderr, "%llu windows, %llu corrupt lines, %llu windows lost\n",
+		(unsigned long long)windows, (unsigned long long)corrupt,
+		(unsigned long long)lost);
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DDRSTAT_SERIAL_H
+#define DDRSTAT_SERIAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "imx6_ddrstat.h"
+
+/*
+ * Compact framing for serial consoles. Every window becomes one text
+ * line, so it survives a console shared with kernel messages and a
+ * login shell:
+ *
+ *   "@D" base64(frame) "\n"
+ *
+ * A frame is a sequence of unsigned LEB128 varints, most of which fit
+ * in two to four bytes, followed by a CRC-16/CCITT (big endian) over
+ * everything before it:
+ *
+ *   u8 version, u8 flags (the DDRSTAT_FLAG_ bits of the stream
+ *   protocol), seq, duration_us, end_raw_us, end_boot_us - end_raw_us,
+ *   (SUSPENDED) suspended_us, (FILTERED) axi_id, axi_id_mask,
+ *   mmdc0[6], mmdc1[6],
+ *   (CORR) corr_realtime_ns, corr_raw_ns, corr_boot_ns,
+ *   corr_uncertainty_ns
+ *
+ * Window timestamps are in microseconds. A typical window takes about
+ * 80 characters, so 115200 baud carries well over 100 windows/s.
+ * Receivers resynchronize on the next "@D" after a corrupted line.
+ */
+
+#define DDRSTAT_SERIAL_VERSION	1
+#define DDRSTAT_SERIAL_MARKER	"@D"
+
+/* longest frame and line including marker, newline and terminator */
+#define DDRSTAT_SERIAL_FRAME	(2 + 23 * 10 + 2)
+#define DDRSTAT_SERIAL_LINE	(2 + (DDRSTAT_SERIAL_FRAME + 2) / 3 * 4 + 2)
+
+size_t serial_encode(char *line, uint32_t seq, const struct perf_sample *s);
+int serial_decode(const char *line, uint32_t *seq, struct perf_sample *s);
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DDRSTAT_SHM_H
+#define DDRSTAT_SHM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "ddrstat_proto.h"
+
+/*
+ * Shared memory between the privileged ddrstat_helper, which owns the
+ * MMDC registers, and unprivileged imx6_ddrstat --shm front ends.
+ *
+ * The helper publishes every window into a ring of slots holding
+ * samples in the stream protocol encoding, then bumps published, which
+ * doubles as a futex for waiting readers. Readers keep their own
+ * position and detect being lapped by the single writer.
+ *
+ * Front ends ask for a filter or interval change by filling in the
+ * req_ fields and then incrementing req_seq. The helper validates and
+ * applies requests between windows and echoes req_seq in ack_seq.
+ */
+
+#define DDRSTAT_SHM_MAGIC	0x4d485344	/* "DSHM" */
+#define DDRSTAT_SHM_VERSION	1
+#define DDRSTAT_SHM_NAME	"/imx6_ddrstat"
+#define DDRSTAT_SHM_SLOTS	64
+
+struct ddrstat_shm {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t helper_pid;
+	uint32_t interval_ms;
+
+	uint32_t req_seq;
+	int32_t req_filter;		/* index into filters[], -1 for none */
+	uint32_t req_interval_ms;	/* 0 leaves the interval alone */
+	uint32_t ack_seq;
+
+	uint32_t published;
+	uint32_t pad;
+	uint8_t slot[DDRSTAT_SHM_SLOTS][DDRSTAT_SAMPLE_SIZE];
+};
+
+/* shm.c */
+struct ddrstat_shm *ddrstat_shm_create(const char *name, uid_t uid,
+				       gid_t gid);
+struct ddrstat_shm *ddrstat_shm_open(const char *name);
+void ddrstat_shm_close(struct ddrstat_shm *shm);
+void ddrstat_shm_publish(struct ddrstat_shm *shm, const struct perf_sample *s);
+int ddrstat_shm_fetch(struct ddrstat_shm *shm, uint32_t *next,
+		      struct perf_sample *s, unsigned int timeout_ms,
+		      uint32_t *lost);
+void ddrstat_shm_request(struct ddrstat_shm *shm, int filter,
+			 unsigned int interval_ms);
+
+#endif
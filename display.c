@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Display underflow early warning. Every configured scanout channel
+ * needs width * height * refresh * bpp / 8 bytes per second, fetched
+ * on time. Underflows happen when other masters push the controller
+ * towards saturation and scanout latency goes up, so the warning
+ * tracks a smoothed busy% with its trend and raises an event when the
+ * value predicted a few windows ahead crosses the limit, or when a
+ * channel is already measured below what it needs.
+ *
+ * --display=CHANNEL:WxH@HZ:BPP[,CHANNEL:...][,limit=PERCENT][,ahead=N]
+ *           [,tolerance=PERCENT]
+ *
+ *   CHANNEL    AXI master doing the scanout, e.g. ipu1-0
+ *   limit      busy% considered unsafe for scanout (default 85)
+ *   ahead      windows to predict ahead (default 3)
+ *   tolerance  measured shortfall that counts as starved (default 5)
+ *
+ * Without a sweep, the sampler alternates between unfiltered windows
+ * and the channels. Events go to stdout with the traffic around them:
+ *
+ *   display-warn window 42 channel ipu1-0 need 497.7 measured 496.1
+ *   busy 84.2 predicted 88.0 display 497.7 other 910.3 [gpu3d-a 330.1]
+ *   display-clear window 57 ...
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+#define DISPLAY_ALPHA		0.3
+#define DISPLAY_HYSTERESIS	5.0
+
+struct display_channel {
+	const struct axi_filter *filter;
+	unsigned int width, height, bpp;
+	double hz;
+	double need_mbps;
+
+	double mbps;		/* last measured */
+	bool measured;
+	double sum_mbps, min_mbps;
+	uint64_t windows;
+	bool starved;
+	bool raised;
+	uint64_t warnings;
+};
+
+static bool enabled;
+static struct display_channel channels[8];
+static unsigned int num_channels;
+static double limit = 85.0;
+static unsigned int ahead = 3;
+static double tolerance = 5.0;
+
+/* smoothed busy% and its per-window trend, over unfiltered windows */
+static double busy_avg, busy_trend, busy_last;
+static bool have_busy;
+static double total_mbps;
+static uint64_t risky_windows, unfiltered_windows;
+
+/* last bandwidth of every master seen in a sweep, indexed like totals */
+static double master_mbps[64];
+
+static int display_channel_parse(const char *item)
+{
+	struct display_channel *ch = &channels[num_channels];
+	char name[32];
+	int n;
+
+	if (num_channels == ARRAY_SIZE(channels))
+		return -1;
+	if (sscanf(item, "%31[^:]:%ux%u@%lf:%u%n", name, &ch->width,
+		   &ch->height, &ch->hz, &ch->bpp, &n) != 5 || item[n])
+		return -1;
+	ch->filter = axi_filter_find(name);
+	if (!ch->filter || !ch->width || !ch->height || ch->hz <= 0.0 ||
+	    !ch->bpp || ch->bpp > 64)
+		return -1;
+
+	ch->need_mbps = (double)ch->width * ch->height * ch->hz *
+			ch->bpp / 8 / 1e6;
+	num_channels++;
+	return 0;
+}
+
+int display_init(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *item, *end, *saveptr;
+
+	if (!copy)
+		return -1;
+
+	for (item = strtok_r(copy, ",", &saveptr); item;
+	     item = strtok_r(NULL, ",", &saveptr)) {
+		if (strncmp(item, "limit=", 6) == 0) {
+			limit = strtod(item + 6, &end);
+			if (*end || limit <= 0.0 || limit > 100.0)
+				goto bad;
+		} else if (strncmp(item, "ahead=", 6) == 0) {
+			ahead = strtoul(item + 6, &end, 0);
+			if (*end)
+				goto bad;
+		} else if (strncmp(item, "tolerance=", 10) == 0) {
+			tolerance = strtod(item + 10, &end);
+			if (*end || tolerance < 0.0 || tolerance >= 100.0)
+				goto bad;
+		} else if (display_channel_parse(item)) {
+			goto bad;
+		}
+	}
+	free(copy);
+
+	if (!num_channels) {
+		fprintf(stderr, "display needs at least one channel\n");
+		return -1;
+	}
+	enabled = true;
+	return 0;
+bad:
+	fprintf(stderr, "invalid display item '%s'\n", item);
+	free(copy);
+	return -1;
+}
+
+bool display_enabled(void)
+{
+	return enabled;
+}
+
+int display_sweep_list(char *buf, size_t size)
+{
+	size_t len = snprintf(buf, size, "all");
+	unsigned int i;
+
+	for (i = 0; i < num_channels && len < size; i++)
+		len += snprintf(buf + len, size - len, ",%s",
+				channels[i].filter->name);
+	return len < size ? 0 : -1;
+}
+
+static double sample_mbps(const struct perf_sample *s)
+{
+	return perf_rate(s, s->mmdc[0].read_bytes + s->mmdc[0].write_bytes +
+			 s->mmdc[1].read_bytes + s->mmdc[1].write_bytes) / 1e6;
+}
+
+static bool display_is_channel(unsigned int idx)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_channels; i++)
+		if ((unsigned int)(channels[i].filter - filters + 1) == idx)
+			return true;
+	return false;
+}
+
+/* The three busiest other masters from the sweep, if there are any */
+static void display_context(char *buf, size_t size)
+{
+	unsigned int i, k, best;
+	bool used[ARRAY_SIZE(master_mbps)] = { false };
+	size_t len = 0;
+
+	buf[0] = '\0';
+	for (k = 0; k < 3; k++) {
+		best = 0;
+		for (i = 1; i < ARRAY_SIZE(master_mbps); i++)
+			if (!used[i] && !display_is_channel(i) &&
+			    master_mbps[i] > 0.0 &&
+			    (!best || master_mbps[i] > master_mbps[best]))
+				best = i;
+		if (!best)
+			break;
+		used[best] = true;
+		len += snprintf(buf + len, size - len, "%s%s %.1f",
+				k ? ", " : " [", filters[best - 1].name,
+				master_mbps[best]);
+		if (len >= size)
+			break;
+	}
+	if (buf[0] && len + 1 < size)
+		strcat(buf, "]");
+}
+
+static void display_event(const char *event, uint64_t window,
+			  const struct display_channel *ch, double predicted)
+{
+	double display = 0.0;
+	char context[160];
+	unsigned int i;
+
+	for (i = 0; i < num_channels; i++)
+		display += channels[i].measured ? channels[i].mbps :
+			   channels[i].need_mbps;
+	display_context(context, sizeof(context));
+
+	printf("%s window %llu channel %s need %.1f measured %.1f busy %.1f predicted %.1f display %.1f other %.1f%s\n",
+	       event, (unsigned long long)window, ch->filter->name,
+	       ch->need_mbps, ch->measured ? ch->mbps : 0.0, busy_last,
+	       predicted, display, fmax(total_mbps - display, 0.0), context);
+	fflush(stdout);
+}
+
+void display_check(uint64_t window, const struct perf_sample *s)
+{
+	struct display_channel *ch;
+	double busy, predicted, mbps;
+	unsigned int i;
+	bool risk;
+
+	if (!enabled || s->suspended_ns || !s->duration_ns)
+		return;
+
+	mbps = sample_mbps(s);
+	if (s->filter) {
+		master_mbps[s->filter - filters + 1] = mbps;
+		for (i = 0; i < num_channels; i++) {
+			ch = &channels[i];
+			if (ch->filter != s->filter)
+				continue;
+			ch->mbps = mbps;
+			ch->measured = true;
+			ch->sum_mbps += mbps;
+			if (!ch->windows || mbps < ch->min_mbps)
+				ch->min_mbps = mbps;
+			ch->windows++;
+			ch->starved = mbps < ch->need_mbps *
+					     (1.0 - tolerance / 100.0);
+		}
+	} else {
+		busy = fmax(mmdc_busy(&s->mmdc[0]), mmdc_busy(&s->mmdc[1]));
+		if (have_busy) {
+			busy_trend = (1 - DISPLAY_ALPHA) * busy_trend +
+				     DISPLAY_ALPHA * (busy - busy_last);
+			busy_avg = (1 - DISPLAY_ALPHA) * busy_avg +
+				   DISPLAY_ALPHA * busy;
+		} else {
+			busy_avg = busy;
+			have_busy = true;
+		}
+		busy_last = busy;
+		total_mbps = mbps;
+		unfiltered_windows++;
+	}
+	if (!have_busy)
+		return;
+
+	/* the smoothed load some windows ahead, never below the last one */
+	predicted = fmax(busy_avg + busy_trend * ahead, busy_last);
+	if (predicted >= limit && !s->filter)
+		risky_windows++;
+
+	for (i = 0; i < num_channels; i++) {
+		ch = &channels[i];
+		risk = predicted >= limit || ch->starved;
+		if (risk && !ch->raised) {
+			ch->raised = true;
+			ch->warnings++;
+			display_event("display-warn", window, ch, predicted);
+		} else if (!risk && ch->raised &&
+			   predicted < limit - DISPLAY_HYSTERESIS) {
+			ch->raised = false;
+			display_event("display-clear", window, ch, predicted);
+		}
+	}
+}
+
+void display_report(FILE *f)
+{
+	const struct display_channel *ch;
+	unsigned int i;
+
+	if (!enabled)
+		return;
+
+	fprintf(f, "display underflow risk, busy limit %.0f%%, %llu of %llu windows predicted above\n",
+		limit, (unsigned long long)risky_windows,
+		(unsigned long long)unfiltered_windows);
+	fprintf(f, "%-10s %-18s %9s %9s %9s %8s\n", "CHANNEL", "MODE",
+		"NEED MB/s", "AVG MB/s", "MIN MB/s", "WARNINGS");
+	for (i = 0; i < num_channels; i++) {
+		char mode[32];
+
+		ch = &channels[i];
+		snprintf(mode, sizeof(mode), "%ux%u@%g:%u", ch->width,
+			 ch->height, ch->hz, ch->bpp);
+		fprintf(f, "%-10s %-18s %9.1f %9.1f %9.1f %8llu\n",
+			ch->filter->name, mode, ch->need_mbps,
+			ch->windows ? ch->sum_mbps / ch->windows : 0.0,
+			ch->windows ? ch->min_mbps : 0.0,
+			(unsigned long long)ch->warnings);
+	}
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * DDR power and energy estimates. Every populated controller draws a
+ * constant background power; on top of that come an energy cost per
+ * busy cycle, per read and write access and per byte moved:
+ *
+ *   P = bg + (busy * e_busy + rd * e_rd + wr * e_wr +
+ *             rdb * e_rdb + wrb * e_wrb) / t
+ *
+ * The presets are ballpark numbers for the parts on our boards, derived
+ * from vendor power calculators; calibrate them against a measurement
+ * on the DDR rail for anything more than relative comparisons.
+ *
+ * --energy=PART[,bg=mW][,busy=pJ][,rd=pJ][,wr=pJ][,rdb=pJ][,wrb=pJ][,fps=N]
+ *
+ * configures the model. The energy sink prints power per controller, the
+ * energy of the window and energy per frame; filtered windows only see
+ * the accesses of one master, for them it prints the power and energy
+ * of that traffic alone. On close it sums up the energy per controller
+ * over the unfiltered windows and summarizes the power per master.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+struct energy_model {
+	const char *part;
+	double bg_mw;		/* background power per controller */
+	double busy_pj;		/* per busy cycle */
+	double rd_pj;		/* per read access */
+	double wr_pj;		/* per write access */
+	double rdb_pj;		/* per byte read */
+	double wrb_pj;		/* per byte written */
+};
+
+static const struct energy_model energy_parts[] = {
+	{ "ddr3",   120.0, 30.0, 300.0, 330.0, 120.0, 130.0 },
+	{ "lpddr2",  30.0, 12.0, 150.0, 170.0,  40.0,  45.0 },
+};
+
+/* the first part unless --energy picked another one */
+static struct energy_model model;
+static double fps = 60.0;
+
+/* per master sums for the summary, index as in perf_totals */
+struct energy_master {
+	uint64_t windows;
+	double mw_sum;
+	double mj[2];		/* per controller, masters only use [0] */
+	double seconds;
+};
+
+static int energy_option(const char *opt)
+{
+	const char *val = strchr(opt, '=');
+	double *coef = NULL;
+	char *end;
+	double v;
+
+	if (!val)
+		return -1;
+	v = strtod(val + 1, &end);
+	if (*end || v < 0.0)
+		return -1;
+
+	if (strncmp(opt, "bg=", 3) == 0)
+		coef = &model.bg_mw;
+	else if (strncmp(opt, "busy=", 5) == 0)
+		coef = &model.busy_pj;
+	else if (strncmp(opt, "rd=", 3) == 0)
+		coef = &model.rd_pj;
+	else if (strncmp(opt, "wr=", 3) == 0)
+		coef = &model.wr_pj;
+	else if (strncmp(opt, "rdb=", 4) == 0)
+		coef = &model.rdb_pj;
+	else if (strncmp(opt, "wrb=", 4) == 0)
+		coef = &model.wrb_pj;
+	else if (strncmp(opt, "fps=", 4) == 0 && v > 0.0)
+		coef = &fps;
+	else
+		return -1;
+
+	*coef = v;
+	return 0;
+}
+
+int energy_init(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *opts, *opt, *saveptr;
+	unsigned int i;
+
+	if (!copy)
+		return -1;
+
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+
+	for (i = 0; i < ARRAY_SIZE(energy_parts); i++)
+		if (strcmp(copy, energy_parts[i].part) == 0)
+			break;
+	if (i == ARRAY_SIZE(energy_parts)) {
+		fprintf(stderr, "unknown DDR part '%s'\n", copy);
+		goto err;
+	}
+	model = energy_parts[i];
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (energy_option(opt)) {
+			fprintf(stderr, "invalid energy option '%s'\n", opt);
+			goto err;
+		}
+	}
+
+	free(copy);
+	return 0;
+err:
+	free(copy);
+	return -1;
+}
+
+/* energy of the traffic itself, in pJ, without background and busy */
+static double energy_traffic_pj(const struct mmdc_stats *st)
+{
+	return st->read_accesses * model.rd_pj +
+	       st->write_accesses * model.wr_pj +
+	       st->read_bytes * model.rdb_pj +
+	       st->write_bytes * model.wrb_pj;
+}
+
+/* average power of one controller over the window, 0 if unpopulated */
+double energy_mmdc_mw(const struct perf_sample *s, int c)
+{
+	const struct mmdc_stats *st = &s->mmdc[c];
+	double t = s->duration_ns * 1e-9;
+
+	if (!st->cycles || t <= 0.0)
+		return 0.0;
+
+	return model.bg_mw + (st->busy_cycles * model.busy_pj +
+			      energy_traffic_pj(st)) * 1e-9 / t;
+}
+
+int energy_open(struct sink *sk)
+{
+	if (!model.part)
+		model = energy_parts[0];
+
+	sk->priv = calloc(64, sizeof(struct energy_master));
+	if (!sk->priv)
+		return -1;
+
+	fprintf(sk->f, "energy model %s: background %.1f mW, busy %.1f pJ/cycle, read %.1f pJ + %.1f pJ/byte, write %.1f pJ + %.1f pJ/byte, %.0f fps\n",
+		model.part, model.bg_mw, model.busy_pj, model.rd_pj,
+		model.rdb_pj, model.wr_pj, model.wrb_pj, fps);
+	return 0;
+}
+
+int energy_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+		 unsigned int n)
+{
+	struct energy_master *masters = sk->priv;
+	double mw[2], total, t, traffic;
+	int c;
+
+	(void)seq;
+	for (; n; n--, s++) {
+		if (s->suspended_ns)
+			continue;
+
+		t = s->duration_ns * 1e-9;
+
+		/*
+		 * Filtered windows only count the accesses of one master,
+		 * report the power of its traffic instead of the totals.
+		 */
+		if (s->filter) {
+			struct energy_master *m =
+				&masters[s->filter - filters + 1];
+
+			if (t <= 0.0)
+				continue;
+			traffic = (energy_traffic_pj(&s->mmdc[0]) +
+				   energy_traffic_pj(&s->mmdc[1])) * 1e-9 / t;
+			m->windows++;
+			m->mw_sum += traffic;
+			m->mj[0] += traffic * t;
+			m->seconds += t;
+			fprintf(sk->f, "%-12s %7.1f mW %9.3f mJ  %.3f mJ/frame\n",
+				s->filter->name, traffic, traffic * t,
+				traffic / fps);
+			continue;
+		}
+
+		for (c = 0; c < 2; c++) {
+			mw[c] = energy_mmdc_mw(s, c);
+			masters[0].mj[c] += mw[c] * t;
+		}
+		total = mw[0] + mw[1];
+		masters[0].windows++;
+		masters[0].seconds += t;
+
+		fprintf(sk->f, "MMDC0 %7.1f mW", mw[0]);
+		if (s->mmdc[1].cycles)
+			fprintf(sk->f, "  MMDC1 %7.1f mW", mw[1]);
+		fprintf(sk->f, "  total %7.1f mW %9.3f mJ  %.3f mJ/frame\n",
+			total, total * t, total / fps);
+	}
+	return 0;
+}
+
+void energy_close(struct sink *sk)
+{
+	struct energy_master *masters = sk->priv;
+	const struct energy_master *all = &masters[0];
+	unsigned int i;
+	double mw;
+
+	if (all->windows) {
+		fprintf(sk->f, "MMDC0 %.1f mJ", all->mj[0]);
+		if (all->mj[1] > 0.0)
+			fprintf(sk->f, "  MMDC1 %.1f mJ", all->mj[1]);
+		fprintf(sk->f, "  total %.1f mJ in %.1f s (%llu windows)\n",
+			all->mj[0] + all->mj[1], all->seconds,
+			(unsigned long long)all->windows);
+	}
+
+	for (i = 1; i < 64; i++) {
+		if (!masters[i].windows)
+			continue;
+		mw = masters[i].mw_sum / masters[i].windows;
+		fprintf(sk->f, "master %-12s %8.1f mW %8.3f mJ/frame %9.1f mJ in %.1f s (%llu windows)\n",
+			filters[i - 1].name, mw, mw / fps, masters[i].mj[0],
+			masters[i].seconds,
+			(unsigned long long)masters[i].windows);
+	}
+	fflush(sk->f);
+	free(masters);
+	sk->priv = NULL;
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Closed loop DDR frequency governor. Drives a devfreq device through
+ * its userspace governor from the measured MMDC load instead of the
+ * kernel's heuristics.
+ *
+ * --governor=DEVICE[,root=DIR][,up=PERCENT][,target=PERCENT][,hold=N]
+ *            [,floor=MASTER:MBPS...]
+ *
+ *   DEVICE   name below /sys/class/devfreq
+ *   root     prefix for the sysfs tree, for testing against a fake one
+ *   up       utilization that raises the clock at once (default 75)
+ *   target   utilization aimed for after a change (default 60)
+ *   hold     windows the load has to stay low before lowering the
+ *            clock (default 5)
+ *   floor    bandwidth kept available for a master, may be repeated
+ *
+ * Busy cycles per second hardly depend on the DDR clock, so busy% at
+ * another operating point is busy% * cur / freq. Utilization is busy%
+ * plus the busy cycles a floor still needs on top of what its master
+ * was last measured at (the whole floor unless a sweep measures it),
+ * at the busy cycles per byte of the current traffic. Only unfiltered
+ * windows steer the clock. The previous governor is restored on exit.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+#define GOV_MAX_FREQS	32
+
+struct gov_floor {
+	const struct axi_filter *filter;
+	double mbps;
+};
+
+static bool enabled;
+static bool simulate;
+static char base[512];
+static char saved[64];
+
+static unsigned long freqs[GOV_MAX_FREQS];
+static unsigned int num_freqs;
+static unsigned int cur;
+
+static double up = 75.0;
+static double target = 60.0;
+static unsigned int hold = 5;
+
+static struct gov_floor floors[16];
+static unsigned int num_floors;
+static double master_mbps[64];	/* last measured, indexed like totals */
+
+static unsigned int low_windows;
+static unsigned int low_want;
+static uint64_t changes;
+
+static int gov_read(const char *attr, char *buf, size_t size)
+{
+	char path[640];
+	FILE *f;
+	int err = 0;
+
+	snprintf(path, sizeof(path), "%s/%s", base, attr);
+	f = fopen(path, "r");
+	if (!f)
+		return -1;
+	if (!fgets(buf, size, f))
+		err = -1;
+	else
+		buf[strcspn(buf, "\n")] = '\0';
+	fclose(f);
+	return err;
+}
+
+static int gov_write(const char *attr, const char *val)
+{
+	char path[640];
+	FILE *f;
+	int err = 0;
+
+	snprintf(path, sizeof(path), "%s/%s", base, attr);
+	f = fopen(path, "w");
+	if (!f)
+		return -1;
+	if (fputs(val, f) < 0)
+		err = -1;
+	if (fclose(f))
+		err = -1;
+	return err;
+}
+
+static int gov_cmp(const void *a, const void *b)
+{
+	unsigned long fa = *(const unsigned long *)a;
+	unsigned long fb = *(const unsigned long *)b;
+
+	return fa < fb ? -1 : fa > fb;
+}
+
+static int gov_set(unsigned int idx, double util)
+{
+	char val[32];
+
+	snprintf(val, sizeof(val), "%lu", freqs[idx]);
+	/* the userspace governor keeps its attribute in a group */
+	if (gov_write("userspace/set_freq", val)) {
+		fprintf(stderr, "governor: userspace/set_freq %s: %s\n", val,
+			strerror(errno));
+		return -1;
+	}
+	if (util >= 0.0) {
+		fprintf(stderr, "governor: %lu -> %lu Hz at %.1f%% utilization\n",
+			freqs[cur], freqs[idx], util);
+		changes++;
+	}
+	if (simulate)
+		sim_set_clock(freqs[idx]);
+	cur = idx;
+	return 0;
+}
+
+static int gov_option(const char *opt)
+{
+	const struct axi_filter *filter;
+	const char *val = strchr(opt, '=');
+	char name[32], *colon, *end;
+
+	if (!val)
+		return -1;
+	val++;
+
+	if (strncmp(opt, "root=", 5) == 0)
+		return 0;
+	if (strncmp(opt, "up=", 3) == 0) {
+		up = strtod(val, &end);
+	} else if (strncmp(opt, "target=", 7) == 0) {
+		target = strtod(val, &end);
+	} else if (strncmp(opt, "hold=", 5) == 0) {
+		hold = strtoul(val, &end, 0);
+	} else if (strncmp(opt, "floor=", 6) == 0) {
+		snprintf(name, sizeof(name), "%s", val);
+		colon = strchr(name, ':');
+		if (!colon || num_floors == ARRAY_SIZE(floors))
+			return -1;
+		*colon = '\0';
+		filter = axi_filter_find(name);
+		if (!filter)
+			return -1;
+		floors[num_floors].filter = filter;
+		floors[num_floors].mbps = strtod(val + (colon + 1 - name),
+						 &end);
+		if (floors[num_floors++].mbps <= 0.0)
+			return -1;
+	} else {
+		return -1;
+	}
+	return *end ? -1 : 0;
+}
+
+int gov_init(const char *spec, bool sim)
+{
+	char *copy = strdup(spec);
+	char *dev, *opts, *opt, *tok, *saveptr;
+	const char *root = "";
+	char buf[1024], cur_buf[32];
+	unsigned long f, now;
+	unsigned int i;
+
+	if (!copy)
+		return -1;
+	dev = copy;
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (strncmp(opt, "root=", 5) == 0)
+			root = opt + 5;
+		if (gov_option(opt)) {
+			fprintf(stderr, "invalid governor option '%s'\n", opt);
+			goto err;
+		}
+	}
+	if (!*dev || strchr(dev, '/') || target <= 0.0 || target >= up ||
+	    up > 100.0 || !hold) {
+		fprintf(stderr, "governor needs a device and 0 < target < up <= 100\n");
+		goto err;
+	}
+	snprintf(base, sizeof(base), "%s/sys/class/devfreq/%s", root, dev);
+
+	if (gov_read("available_frequencies", buf, sizeof(buf))) {
+		perror(base);
+		goto err;
+	}
+	for (tok = strtok_r(buf, " ", &saveptr); tok;
+	     tok = strtok_r(NULL, " ", &saveptr)) {
+		f = strtoul(tok, NULL, 0);
+		if (f && num_freqs < GOV_MAX_FREQS)
+			freqs[num_freqs++] = f;
+	}
+	if (!num_freqs) {
+		fprintf(stderr, "%s: no operating points\n", base);
+		goto err;
+	}
+	qsort(freqs, num_freqs, sizeof(freqs[0]), gov_cmp);
+
+	if (gov_read("governor", saved, sizeof(saved)) ||
+	    (strcmp(saved, "userspace") && gov_write("governor", "userspace"))) {
+		fprintf(stderr, "%s: cannot select the userspace governor\n",
+			base);
+		goto err;
+	}
+
+	/* start from the operating point in use */
+	now = gov_read("cur_freq", cur_buf, sizeof(cur_buf)) ?
+	      freqs[num_freqs - 1] : strtoul(cur_buf, NULL, 0);
+	cur = num_freqs - 1;
+	for (i = 0; i < num_freqs; i++) {
+		if (freqs[i] >= now) {
+			cur = i;
+			break;
+		}
+	}
+	simulate = sim;
+	enabled = true;
+	free(copy);
+	return gov_set(cur, -1.0);
+err:
+	free(copy);
+	return -1;
+}
+
+bool gov_enabled(void)
+{
+	return enabled;
+}
+
+/*
+ * Utilization in percent of controller c with the floors reserved. The
+ * controllers carry the floor bytes in proportion to their traffic, at
+ * their busy cycles per byte, which comes down to this share of the
+ * busy cycles.
+ */
+static double gov_util(const struct perf_sample *s, int c,
+		       double floor_bytes, double all_bytes)
+{
+	const struct mmdc_stats *st = &s->mmdc[c];
+	double extra = 0.0;
+
+	if (!st->cycles)
+		return 0.0;
+	if (all_bytes > 0.0)
+		extra = st->busy_cycles * floor_bytes / all_bytes;
+	return 100.0 * (st->busy_cycles + extra) / st->cycles;
+}
+
+void gov_update(const struct perf_sample *s)
+{
+	double util = 0.0, u, floor_mbps = 0.0, all_bytes = 0.0, need;
+	unsigned int i, want;
+	int c;
+
+	if (!enabled || s->suspended_ns || !s->duration_ns)
+		return;
+
+	if (s->filter) {
+		master_mbps[s->filter - filters + 1] =
+			perf_rate(s, s->mmdc[0].read_bytes +
+				     s->mmdc[0].write_bytes) / 1e6 +
+			perf_rate(s, s->mmdc[1].read_bytes +
+				     s->mmdc[1].write_bytes) / 1e6;
+		return;
+	}
+
+	for (i = 0; i < num_floors; i++) {
+		need = floors[i].mbps -
+		       master_mbps[floors[i].filter - filters + 1];
+		if (need > 0.0)
+			floor_mbps += need;
+	}
+	for (c = 0; c < 2; c++)
+		all_bytes += (double)s->mmdc[c].read_bytes +
+			     s->mmdc[c].write_bytes;
+	for (c = 0; c < 2; c++) {
+		u = gov_util(s, c, floor_mbps * s->duration_ns / 1e3,
+			     all_bytes);
+		if (u > util)
+			util = u;
+	}
+
+	/* lowest operating point that brings utilization to target */
+	for (want = 0; want < num_freqs - 1; want++)
+		if (util * freqs[cur] / freqs[want] <= target)
+			break;
+
+	if (want > cur) {
+		low_windows = 0;
+		if (util > up)
+			gov_set(want, util);
+		return;
+	}
+	if (want == cur) {
+		low_windows = 0;
+		return;
+	}
+
+	/* lower only after hold windows, to the highest point they asked */
+	if (!low_windows || want > low_want)
+		low_want = want;
+	if (++low_windows < hold)
+		return;
+	low_windows = 0;
+	gov_set(low_want, util);
+}
+
+void gov_exit(void)
+{
+	if (!enabled)
+		return;
+	if (strcmp(saved, "userspace") && gov_write("governor", saved))
+		fprintf(stderr, "governor: cannot restore '%s'\n", saved);
+	fprintf(stderr, "governor: %llu frequency changes\n",
+		(unsigned long long)changes);
+	enabled = false;
+}
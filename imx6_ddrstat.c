@@ -28,300 +28,950 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
-#include <sys/mman.h>
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
 #include <sys/time.h>
+#include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <fcntl.h>
 
-#define PAGE_SIZE 4096
+#include "imx6_ddrstat.h"
+#include "ddrstat_shm.h"
 
-#define MMDC0_BASE 0x021b0000
-#define MMDC1_BASE 0x021b4000
+/* boottime running ahead of the raw clock by more than this is a suspend */
+#define SUSPEND_SLACK_NS	50000000
 
-#define MMDC_MADPCR0 0x0410
-#define MMDC_MADPCR1 0x0414
-#define MMDC_MADPSR0 0x0418	/* total cycles */
-#define MMDC_MADPSR1 0x041c	/* busy cycles */
-#define MMDC_MADPSR2 0x0420	/* total read accesses */
-#define MMDC_MADPSR3 0x0424	/* total write accesses */
-#define MMDC_MADPSR4 0x0428	/* total read bytes */
-#define MMDC_MADPSR5 0x042c	/* total write bytes */
+static void *mmdc0, *mmdc1;
+
+/* with --shm, windows come from ddrstat_helper instead of the MMDC */
+static const char *shm_name;
+static struct ddrstat_shm *shm;
+static struct perf_sample shm_sample;
+static uint32_t shm_next, shm_lost;
+static bool shm_gone;
+
+/* with --replay, windows come from a binary recording */
+static const char *replay_spec;
+static struct perf_sample replay_sample;
+
+static unsigned short axi_id;
+static unsigned short axi_id_mask;
+static const struct axi_filter *axi_filter;
+static bool simulate;
+
+static uint64_t perf_start_raw, perf_start_boot;
+static unsigned int interval_ms = 1000;
+
+/* clock correlation records are attached every corr_ms */
+static unsigned int corr_ms = 60000;
+static uint64_t corr_next_raw;
+
+/* end windows on wall clock multiples of the interval */
+static bool align;
+static struct timespec align_next;
+static volatile sig_atomic_t quit;
 
-#define MADPCR0_DBG_EN	(1 << 0)
-#define MADPCR0_DBG_RST	(1 << 1)
-#define MADPCR0_PRF_FRZ	(1 << 2)
-#define MADPCR0_CYC_OVF	(1 << 3)
+/* AXI filters cycled through by --sweep, NULL stands for "all" */
+static const struct axi_filter *sweep[64];
+static unsigned int sweep_len;
+static unsigned int sweep_pos;
 
-#define MADPCR1_PRF_AXI_ID_SHIFT	0	/* profiling AXI ID */
-#define MADPCR1_PRF_AXI_ID_MASK_SHIFT	16	/* profiling AXI ID mask */
+/* per filter totals, index 0 for unfiltered windows, then filters[] */
+static struct perf_totals totals[64];
+static uint64_t windows;
+static uint64_t suspends;
+
+static int perf_init(void)
+{
+	int fd;
+	int err = 0;
+
+	if (shm_name) {
+		shm = ddrstat_shm_open(shm_name);
+		if (!shm) {
+			perror(shm_name);
+			return -1;
+		}
+		shm_next = __atomic_load_n(&shm->published, __ATOMIC_ACQUIRE);
+		ddrstat_shm_request(shm, axi_filter ? axi_filter - filters : -1,
+				    interval_ms);
+		return 0;
+	}
+
+	if (replay_spec)
+		return replay_open(replay_spec);
+
+	fd = simulate ? -1 : open("/dev/mem", O_RDWR);
+	if (fd == -1 && !simulate)
+		return -1;
+
+	mmdc0 = mmdc_map(fd, MMDC0_BASE, simulate);
+	mmdc1 = mmdc_map(fd, MMDC1_BASE, simulate);
+
+	if (!mmdc0 || !mmdc1)
+		err = -1;
+	if (mmdc0)
+		mmdc_arm(mmdc0, axi_id, axi_id_mask);
+	if (mmdc1)
+		mmdc_arm(mmdc1, axi_id, axi_id_mask);
+
+	if (fd != -1)
+		close(fd);
+	return err;
+}
 
 /*
- * AXI IDs that match
- * (AXI-ID & PRF_AXI_ID_MASK) Xnor (PRF_AXI_ID & PRF_AXI_ID_MASK)
- * are taken for profiling
- *
- * To monitor AXI ID's between A100 till A1FF, use
- * - PRF_AXI_ID= 0xa100
- * - PRF_AXI_ID_MASK = 0xff00
+ * The MMDC is reinitialized when leaving suspend, which clears the
+ * profiling setup. Program it again; the counters stay frozen until
+ * the next perf_start().
  */
+static void perf_rearm(void)
+{
+	if (mmdc0)
+		mmdc_arm(mmdc0, axi_id, axi_id_mask);
+	if (mmdc1)
+		mmdc_arm(mmdc1, axi_id, axi_id_mask);
+}
 
-static void *mmdc0, *mmdc1;
+static uint64_t timespec_ns(const struct timespec *ts)
+{
+	return (uint64_t)ts->tv_sec * 1000000000ull + ts->tv_nsec;
+}
 
-struct mmdc_stats {
-	uint32_t cycles;
-	uint32_t busy_cycles;
-	uint32_t read_accesses;
-	uint32_t write_accesses;
-	uint32_t read_bytes;
-	uint32_t write_bytes;
-};
+static uint64_t clock_ns(clockid_t clock)
+{
+	struct timespec ts;
 
-static struct mmdc_stats mmdc0_end;
-static struct mmdc_stats mmdc1_end;
+	clock_gettime(clock, &ts);
+	return timespec_ns(&ts);
+}
 
-static unsigned short axi_id;
-static unsigned short axi_id_mask;
-static bool pretty;
+static void clock_correlate(struct clock_corr *corr)
+{
+	uint64_t raw0, raw1;
 
-static void *mmdc_init(int fd, unsigned base)
+	raw0 = clock_ns(CLOCK_MONOTONIC_RAW);
+	corr->realtime_ns = clock_ns(CLOCK_REALTIME);
+	corr->boot_ns = clock_ns(CLOCK_BOOTTIME);
+	raw1 = clock_ns(CLOCK_MONOTONIC_RAW);
+
+	corr->raw_ns = raw0 + (raw1 - raw0) / 2;
+	corr->uncertainty_ns = raw1 - raw0;
+}
+
+/* Switch the AXI filter, must only be called while the counters are frozen */
+static void perf_set_filter(const struct axi_filter *filter)
 {
-	void *mem = mmap(NULL, PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd,
-			 base);
-	volatile uint32_t *mmdc = mem;
+	axi_filter = filter;
+	axi_id = filter ? filter->axi_id : 0;
+	axi_id_mask = filter ? filter->axi_id_mask : 0;
+	if (mmdc0)
+		mmdc_set_filter(mmdc0, axi_id, axi_id_mask);
+	if (mmdc1)
+		mmdc_set_filter(mmdc1, axi_id, axi_id_mask);
+	/* the helper switches after the window it is counting */
+	if (shm)
+		ddrstat_shm_request(shm, filter ? filter - filters : -1, 0);
+}
 
-	if (mem == MAP_FAILED)
-		return NULL;
+static void perf_start(void)
+{
+	perf_start_raw = clock_ns(CLOCK_MONOTONIC_RAW);
+	perf_start_boot = clock_ns(CLOCK_BOOTTIME);
+
+	if (mmdc0)
+		mmdc_start(mmdc0, simulate);
+	if (mmdc1)
+		mmdc_start(mmdc1, simulate);
+}
+
+static void perf_stop(struct perf_sample *s)
+{
+	int64_t slept;
+
+	if (replay_spec) {
+		/* taken as recorded, including suspends and correlation */
+		*s = replay_sample;
+		if (s->suspended_ns)
+			suspends++;
+		return;
+	}
+
+	if (shm) {
+		/* counters, timestamps and filter as seen by the helper */
+		*s = shm_sample;
+	} else {
+		s->end_raw_ns = clock_ns(CLOCK_MONOTONIC_RAW);
+		s->end_boot_ns = clock_ns(CLOCK_BOOTTIME);
+
+		if (mmdc0 && mmdc_stop(mmdc0, simulate, &s->mmdc[0]))
+			printf("overflow 0!\n");
+		if (mmdc1 && mmdc_stop(mmdc1, simulate, &s->mmdc[1]))
+			printf("overflow 1!\n");
 
-	mmdc[MMDC_MADPCR0 >> 2] = 0;
-	/* assert DBG_RST, write 1 to clear CYC_OVF */
-	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_RST | MADPCR0_CYC_OVF;
-	/* deassert DBG_RST, enable DBG_EN and set PRF_FRZ */
-	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN | MADPCR0_PRF_FRZ;
+		s->start_raw_ns = perf_start_raw;
+		s->start_boot_ns = perf_start_boot;
+		s->filter = axi_filter;
+	}
+	s->duration_ns = s->end_raw_ns - s->start_raw_ns;
 
-	mmdc[MMDC_MADPCR1 >> 2] = (axi_id_mask << MADPCR1_PRF_AXI_ID_MASK_SHIFT)
-				| (axi_id << MADPCR1_PRF_AXI_ID_SHIFT);
+	/* CLOCK_BOOTTIME keeps running while suspended, the raw clock stops */
+	slept = (int64_t)(s->end_boot_ns - s->start_boot_ns) -
+		(int64_t)s->duration_ns;
+	s->suspended_ns = slept > SUSPEND_SLACK_NS ? slept : 0;
+	if (s->suspended_ns) {
+		suspends++;
+		perf_rearm();
+	}
+	s->sweep = sweep_len > 0;
 
-	return mem;
+	s->has_corr = corr_ms && s->end_raw_ns >= corr_next_raw;
+	if (s->has_corr) {
+		clock_correlate(&s->corr);
+		corr_next_raw = s->end_raw_ns + corr_ms * 1000000ull;
+	}
 }
 
-static void mmdc_read(volatile uint32_t *mmdc, struct mmdc_stats *st)
+static void perf_close(void)
 {
-	st->cycles         = mmdc[MMDC_MADPSR0 >> 2];
-	st->busy_cycles    = mmdc[MMDC_MADPSR1 >> 2];
-	st->read_accesses  = mmdc[MMDC_MADPSR2 >> 2];
-	st->write_accesses = mmdc[MMDC_MADPSR3 >> 2];
-	st->read_bytes     = mmdc[MMDC_MADPSR4 >> 2];
-	st->write_bytes    = mmdc[MMDC_MADPSR5 >> 2];
+	if (mmdc0)
+		mmdc_unmap(mmdc0, simulate);
+	if (mmdc1)
+		mmdc_unmap(mmdc1, simulate);
+	if (replay_spec)
+		replay_close();
+	if (shm) {
+		if (shm_gone)
+			fprintf(stderr, "ddrstat_helper exited\n");
+		if (shm_lost)
+			fprintf(stderr, "%u windows lost from shared memory\n",
+				shm_lost);
+		ddrstat_shm_close(shm);
+	}
 }
 
-static void mmdc_print_pretty(const char *tag, struct mmdc_stats *st)
+void setup_axi_filter(const char *master)
 {
-	static const char * const unit[] = { "B", "KiB", "MiB", "GiB" };
-	unsigned long read_size = 0, write_size = 0;
-	unsigned long read_count = st->read_bytes;
-	unsigned long write_count = st->write_bytes;
-	int read_unit = 0, write_unit = 0;
+	const struct axi_filter *filter = axi_filter_find(master);
 
-	if (st->read_accesses)
-		read_size = (read_count + st->read_accesses - 1) /
-			    st->read_accesses;
-	if (st->write_accesses)
-		write_size = (write_count + st->write_accesses - 1) /
-			     st->write_accesses;
+	if (filter) {
+		printf("filtering for AXI IDs from master '%s'\n",
+		       filter->name);
+		perf_set_filter(filter);
+		return;
+	}
 
-	while (read_count > 1023 && read_unit < 3) {
-		read_count /= 1024;
-		read_unit++;
+	printf("not filtering for AXI IDs. Possible AXI masters:\n ");
+	for (filter = filters; filter->name != NULL; filter++)
+		printf(" %s", filter->name);
+	printf("\n");
+	perf_set_filter(NULL);
+}
+
+/*
+ * Parse a comma separated list of AXI masters to sweep over, one per
+ * interval. Without a list, sweep over all top level masters, preceded
+ * by an unfiltered window.
+ */
+static int sweep_setup(const char *list)
+{
+	const struct axi_filter *steps[ARRAY_SIZE(sweep)];
+	const struct axi_filter *filter;
+	char *names, *name, *saveptr;
+	unsigned int len = 0;
+
+	if (!list || !*list) {
+		steps[len++] = NULL;
+		for (filter = filters; filter->name != NULL; filter++)
+			if (axi_filter_is_toplevel(filter))
+				steps[len++] = filter;
+		goto out;
 	}
 
-	while (write_count > 1023 && write_unit < 3) {
-		write_count /= 1024;
-		write_unit++;
+	names = strdup(list);
+	if (!names)
+		return -1;
+
+	for (name = strtok_r(names, ",", &saveptr); name;
+	     name = strtok_r(NULL, ",", &saveptr)) {
+		if (len == ARRAY_SIZE(steps))
+			break;
+		if (strcmp(name, "all") == 0) {
+			steps[len++] = NULL;
+			continue;
+		}
+		filter = axi_filter_find(name);
+		if (!filter) {
+			fprintf(stderr, "unknown AXI master '%s'\n", name);
+			free(names);
+			return -1;
+		}
+		steps[len++] = filter;
 	}
 
-	printf("%s %.2f%% busy %lu %s reads (%lu B / access) %lu %s writes (%lu B / access)",
-	       tag, (double)100.0 * st->busy_cycles / st->cycles,
-	       read_count, unit[read_unit], read_size,
-	       write_count, unit[write_unit], write_size);
+	free(names);
+	if (!len)
+		return -1;
+out:
+	memcpy(sweep, steps, len * sizeof(steps[0]));
+	sweep_len = len;
+	sweep_pos = 0;
+	return 0;
 }
 
-static void mmdc_print(const char *tag, struct mmdc_stats *st)
+/* Masters an analysis needs windows of, "all" for unfiltered ones */
+static struct sweep_need {
+	const char *option;
+	char list[1024];
+} sweep_needs[8];
+static unsigned int num_sweep_needs;
+
+static int sweep_need(const char *option,
+		      int (*list)(char *buf, size_t size))
 {
-	if (pretty)
-		mmdc_print_pretty(tag, st);
-	else
-		printf("%s %.2f%% busy %u reads (%u bytes) %u writes (%u bytes)",
-		       tag, (double)100.0 * st->busy_cycles / st->cycles,
-		       st->read_accesses, st->read_bytes,
-		       st->write_accesses, st->write_bytes);
+	struct sweep_need *need = &sweep_needs[num_sweep_needs];
+
+	if (num_sweep_needs == ARRAY_SIZE(sweep_needs))
+		return -1;
+	if (list(need->list, sizeof(need->list))) {
+		fprintf(stderr, "%s: too many masters\n", option);
+		return -1;
+	}
+	need->option = option;
+	num_sweep_needs++;
+	return 0;
 }
 
-static int perf_init(void)
+static bool list_has(const char *list, const char *name)
 {
-	int fd = open("/dev/mem", O_RDWR);
+	size_t n = strlen(name);
+	const char *p;
+
+	for (p = list; (p = strstr(p, name)); p += n)
+		if ((p == list || p[-1] == ',') && (p[n] == ',' || !p[n]))
+			return true;
+	return false;
+}
+
+/*
+ * Merge what all analyses need into one sweep list, starting with an
+ * unfiltered window unless only processes are watched (--procs is
+ * always the last one to ask).
+ */
+static int sweep_merge(char *buf, size_t size)
+{
+	char *names, *name, *saveptr;
+	size_t len;
+	unsigned int i;
 	int err = 0;
 
-	if (fd == -1)
+	len = snprintf(buf, size, "%s",
+		       strcmp(sweep_needs[0].option, "--procs") ? "all" : "");
+	for (i = 0; i < num_sweep_needs && !err; i++) {
+		names = strdup(sweep_needs[i].list);
+		if (!names)
+			return -1;
+		for (name = strtok_r(names, ",", &saveptr); name;
+		     name = strtok_r(NULL, ",", &saveptr)) {
+			if (list_has(buf, name))
+				continue;
+			len += snprintf(buf + len, size - len, "%s%s",
+					len ? "," : "", name);
+			if (len >= size) {
+				fprintf(stderr, "too many masters to sweep\n");
+				err = -1;
+				break;
+			}
+		}
+		free(names);
+	}
+	return err;
+}
+
+/* The first master of list the sweep does not visit, NULL if none */
+static const char *sweep_lacks(const char *list)
+{
+	static char missing[32];
+	const struct axi_filter *filter;
+	char *names, *name, *saveptr;
+	unsigned int i;
+
+	names = strdup(list);
+	if (!names)
+		return list;
+	for (name = strtok_r(names, ",", &saveptr); name;
+	     name = strtok_r(NULL, ",", &saveptr)) {
+		filter = strcmp(name, "all") ? axi_filter_find(name) : NULL;
+		for (i = 0; i < sweep_len; i++)
+			if (sweep[i] == filter)
+				break;
+		if (i == sweep_len) {
+			snprintf(missing, sizeof(missing), "%s", name);
+			free(names);
+			return missing;
+		}
+	}
+	free(names);
+	return NULL;
+}
+
+static void sweep_next(void)
+{
+	if (!sweep_len)
+		return;
+
+	sweep_pos = (sweep_pos + 1) % sweep_len;
+	perf_set_filter(sweep[sweep_pos]);
+}
+
+static void perf_wait(unsigned int ms)
+{
+	struct timespec ts = {
+		.tv_sec = ms / 1000,
+		.tv_nsec = (ms % 1000) * 1000000,
+	};
+
+	while (nanosleep(&ts, &ts) && errno == EINTR && !quit)
+		;
+}
+
+/* Wait for the helper to publish the next window */
+static int perf_shm_wait(bool dashboard)
+{
+	while (!quit) {
+		if (!ddrstat_shm_fetch(shm, &shm_next, &shm_sample,
+				       dashboard ? 0 : 100, &shm_lost))
+			return 0;
+		if (kill(shm->helper_pid, 0) && errno == ESRCH) {
+			shm_gone = true;
+			return -1;
+		}
+		/* keep the dashboard responsive to keys and resizes */
+		if (dashboard && dashboard_wait(20) < 0)
+			return -1;
+	}
+	return -1;
+}
+
+/* Wait until the next recorded window is due, -1 at the end */
+static int perf_replay_wait(bool dashboard)
+{
+	unsigned int ms;
+
+	if (replay_next(&replay_sample, &ms))
 		return -1;
+	if (dashboard)
+		return dashboard_wait(ms);
+	if (ms)
+		perf_wait(ms);
+	return quit ? -1 : 0;
+}
 
-	mmdc0 = mmdc_init(fd, MMDC0_BASE);
-	mmdc1 = mmdc_init(fd, MMDC1_BASE);
+/*
+ * With --align, windows end on wall clock multiples of the interval, so
+ * devices synchronized by NTP or PTP sample the same time spans. Sleeps
+ * are absolute to avoid accumulating drift. If a boundary was missed,
+ * the window simply ends on the next one.
+ */
+static void align_next_boundary(void)
+{
+	uint64_t step = interval_ms * 1000000ull;
+	uint64_t now = clock_ns(CLOCK_REALTIME);
+	uint64_t next = (now / step + 1) * step;
 
-	if (!mmdc0 || !mmdc1)
-		err = -1;
+	align_next.tv_sec = next / 1000000000;
+	align_next.tv_nsec = next % 1000000000;
+}
 
-	close(fd);
-	return err;
+static void align_wait(void)
+{
+	while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &align_next,
+			       NULL) == EINTR && !quit)
+		;
 }
 
-static void perf_start(void)
+/* milliseconds until the next aligned boundary, for the dashboard */
+static unsigned int align_remaining_ms(void)
 {
-	volatile uint32_t *mmdc = mmdc0;
+	int64_t ns = timespec_ns(&align_next) - clock_ns(CLOCK_REALTIME);
 
-	if (mmdc) {
-		/* Assert reset, clear overflow flag */
-		mmdc[MMDC_MADPCR0 >> 2] |= MADPCR0_DBG_RST | MADPCR0_CYC_OVF;
-		mmdc[MMDC_MADPCR0 >> 2] &= ~(MADPCR0_DBG_RST | MADPCR0_PRF_FRZ);
+	return ns > 0 ? (ns + 999999) / 1000000 : 0;
+}
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	quit = 1;
+	sinks_interrupt();
+}
+
+static struct perf_totals *perf_totals_for(const struct axi_filter *filter)
+{
+	return &totals[filter ? filter - filters + 1 : 0];
+}
+
+static void perf_account(const struct perf_sample *s)
+{
+	windows++;
+	/* the counters of a window spanning a suspend are meaningless */
+	if (s->suspended_ns)
+		return;
+	perf_totals_add(perf_totals_for(s->filter), s);
+}
+
+/* Text for the control socket snapshot command, terminated by "end" */
+static char *perf_snapshot(const struct perf_sample *s)
+{
+	const struct axi_filter *filter;
+	char *text = NULL;
+	size_t size;
+	FILE *f = open_memstream(&text, &size);
+	unsigned int i;
+	int c;
+
+	if (!f)
+		return NULL;
+
+	fprintf(f, "window %llu interval_ms %u filter %s sweep %s suspends %llu\n",
+		(unsigned long long)windows, interval_ms,
+		axi_filter ? axi_filter->name : "all",
+		sweep_len ? "on" : "off", (unsigned long long)suspends);
+	for (c = 0; c < 2; c++) {
+		const struct mmdc_stats *st = &s->mmdc[c];
+
+		fprintf(f, "last mmdc%d filter %s duration_ns %llu cycles %u busy_cycles %u read_accesses %u write_accesses %u read_bytes %u write_bytes %u\n",
+			c, s->filter ? s->filter->name : "all",
+			(unsigned long long)s->duration_ns, st->cycles,
+			st->busy_cycles, st->read_accesses,
+			st->write_accesses, st->read_bytes, st->write_bytes);
 	}
-	mmdc = mmdc1;
-	if (mmdc) {
-		/* Assert reset, clear overflow flag */
-		mmdc[MMDC_MADPCR0>>2] |= MADPCR0_DBG_RST | MADPCR0_CYC_OVF;
-		mmdc[MMDC_MADPCR0>>2] &= ~(MADPCR0_DBG_RST | MADPCR0_PRF_FRZ);
+	for (i = 0; i < ARRAY_SIZE(totals); i++) {
+		const struct perf_totals *t = &totals[i];
+
+		if (!t->windows)
+			continue;
+		filter = i ? &filters[i - 1] : NULL;
+		for (c = 0; c < 2; c++)
+			fprintf(f, "total mmdc%d filter %s windows %llu duration_ns %llu cycles %llu busy_cycles %llu read_accesses %llu write_accesses %llu read_bytes %llu write_bytes %llu\n",
+				c, filter ? filter->name : "all",
+				(unsigned long long)t->windows,
+				(unsigned long long)t->duration_ns,
+				(unsigned long long)t->mmdc[c].cycles,
+				(unsigned long long)t->mmdc[c].busy_cycles,
+				(unsigned long long)t->mmdc[c].read_accesses,
+				(unsigned long long)t->mmdc[c].write_accesses,
+				(unsigned long long)t->mmdc[c].read_bytes,
+				(unsigned long long)t->mmdc[c].write_bytes);
 	}
+	fprintf(f, "end\n");
+	fclose(f);
+
+	return text;
 }
 
-static void perf_stop(void)
+/*
+ * Apply what came in on the control socket during the last window. Runs
+ * between perf_stop() and perf_start(), so filter changes hit frozen
+ * counters and the next window starts with the new settings.
+ */
+static void control_apply(const struct perf_sample *s, bool dashboard)
 {
-	volatile uint32_t *mmdc = mmdc0;
+	struct ctrl_request req;
 
-	if (mmdc) {
-		mmdc[MMDC_MADPCR0>>2] |= MADPCR0_PRF_FRZ;
-		if (mmdc[MMDC_MADPCR0>>2] & MADPCR0_CYC_OVF)
-			printf("overflow 0!\n");
-		mmdc_read(mmdc, &mmdc0_end);
+	if (!ctrl_take(&req))
+		return;
+
+	if (req.sweep_stop)
+		sweep_len = 0;
+	if (req.sweep_start && sweep_setup(req.sweep_list) == 0)
+		perf_set_filter(sweep[0]);
+	if (req.set_filter) {
+		sweep_len = 0;
+		perf_set_filter(req.filter);
 	}
-	mmdc = mmdc1;
-	if (mmdc) {
-		mmdc[MMDC_MADPCR0>>2] |= MADPCR0_PRF_FRZ;
-		if (mmdc[MMDC_MADPCR0>>2] & MADPCR0_CYC_OVF)
-			printf("overflow 1!\n");
-		mmdc_read(mmdc, &mmdc1_end);
+	if (req.set_interval) {
+		interval_ms = req.interval_ms;
+		if (shm)
+			ddrstat_shm_request(shm, axi_filter ?
+					    axi_filter - filters : -1,
+					    interval_ms);
 	}
+	if (req.reset) {
+		memset(totals, 0, sizeof(totals));
+		windows = 0;
+		suspends = 0;
+	}
+	if (dashboard)
+		dashboard_configure(interval_ms, sweep_len > 0);
+
+	ctrl_done(req.snapshot ? perf_snapshot(s) : NULL);
 }
 
-static void perf_print(void)
+/* Apply the settings of the next plan step, -1 once the plan is done */
+static int plan_next(unsigned int default_ms, bool dashboard)
 {
-	if (mmdc0) {
-		mmdc_print("MMDC0", &mmdc0_end);
-		if (mmdc1_end.cycles) {
-			printf("\t");
-			mmdc_print("MMDC1", &mmdc1_end);
-		}
-		printf("\n");
+	const struct plan_step *st = plan_begin();
+
+	if (!st)
+		return -1;
+
+	sweep_len = 0;
+	if (st->sweep) {
+		if (sweep_setup(st->sweep_list))
+			return -1;
+		perf_set_filter(sweep[0]);
+	} else {
+		perf_set_filter(st->filter);
 	}
+	interval_ms = st->interval_ms ? st->interval_ms : default_ms;
+	if (shm)
+		ddrstat_shm_request(shm, axi_filter ? axi_filter - filters : -1,
+				    interval_ms);
+	if (dashboard)
+		dashboard_configure(interval_ms, sweep_len > 0);
+	else
+		fprintf(stderr, "plan step %s\n", st->name);
+	return 0;
 }
 
-static void perf_close(void)
+/* Collect finished hooks, plan commands run in groups of their own */
+static void reap_hooks(void)
 {
-	if (mmdc0)
-		munmap(mmdc0, PAGE_SIZE);
-	if (mmdc1)
-		munmap(mmdc1, PAGE_SIZE);
-}
-
-struct axi_filter {
-	char *name;
-	unsigned short axi_id_mask;
-	unsigned short axi_id;
-};
-
-/* Table 43-8. i.MX 6Dual/6Quad AXI ID */
-static struct axi_filter filters[] = {
-	{ "arm-s0",    0b11100000000111, 0b00000000000000 },
-	{ "arm-s1",    0b11100000000111, 0b00000000000001 },
-	{ "ipu1",      0b11111111100111, 0b00000000000100 },
-	{ "ipu1-0",    0b11111111111111, 0b00000000000100 },
-	{ "ipu1-1",    0b11111111111111, 0b00000000001100 },
-	{ "ipu1-2",    0b11111111111111, 0b00000000010100 },
-	{ "ipu1-3",    0b11111111111111, 0b00000000011100 },
-	{ "ipu2",      0b11111111100111, 0b00000000000101 },
-	{ "ipu2-0",    0b11111111111111, 0b00000000000101 },
-	{ "ipu2-1",    0b11111111111111, 0b00000000001101 },
-	{ "ipu2-2",    0b11111111111111, 0b00000000010101 },
-	{ "ipu2-3",    0b11111111111111, 0b00000000011101 },
-	{ "gpu3d-a",   0b11110000111111, 0b00000000000010 },
-	{ "gpu2d-a",   0b11110000111111, 0b00000000001010 },
-	{ "vdoa",      0b11111100111111, 0b00000000010010 },
-	{ "openvg",    0b11110000111111, 0b00000000100010 },
-	{ "hdmi",      0b11111111111111, 0b00000100011010 },
-	{ "sdma-brst", 0b11111111111111, 0b00000101011010 },
-	{ "sdma-per",  0b11111111111111, 0b00000110011010 },
-	{ "caam",      0b00001111111111, 0b00000000011010 },
-	{ "usb",       0b11001111111111, 0b00000001011010 },
-	{ "enet",      0b11111111111111, 0b00000010011010 },
-	{ "hsi",       0b11111111111111, 0b00000011011010 },
-	{ "usdhc1",    0b11111111111111, 0b00000111011010 },
-	{ "gpu3d-b",   0b11110000111111, 0b00000000000011 },
-	/* the reference manual lists a second gpu3d-b instead of gpu2d-b */
-	{ "gpu2d-b",   0b11110000111111, 0b00000000001011 },
-	{ "vpu-prime", 0b11110000111111, 0b00000000010011 },
-	{ "pcie",      0b11100000111111, 0b00000000011011 },
-	{ "dap",       0b11111111111111, 0b00000000100011 },
-	{ "apbh-dma",  0b11111111111111, 0b00000010100011 },
-	{ "bch40",     0b00001111111111, 0b00000001100011 },
-	{ "sata",      0b11111111111111, 0b00000011100011 },
-	{ "mlb150",    0b11111111111111, 0b00000100100011 },
-	{ "usdhc2",    0b11111111111111, 0b00000101100011 },
-	{ "usdhc3",    0b11111111111111, 0b00000110100011 },
-	{ "usdhc4",    0b11111111111111, 0b00000111100011 },
-	{},
-};
+	while (waitpid(0, NULL, WNOHANG) > 0)
+		;
+}
 
-void setup_axi_filter(const char *master)
+static void adapt_interval(const struct perf_sample *s, bool dashboard)
 {
-	struct axi_filter *filter;
+	unsigned int ms = adapt_next(s, interval_ms);
 
-	for (filter = filters; filter->name != NULL; filter++) {
-		if (strcmp(filter->name, master) == 0) {
-			printf("filtering for AXI IDs from master '%s'\n",
-			       filter->name);
-			axi_id = filter->axi_id;
-			axi_id_mask = filter->axi_id_mask;
-			return;
-		}
-	}
+	if (ms == interval_ms)
+		return;
+	interval_ms = ms;
+	if (dashboard)
+		dashboard_configure(interval_ms, sweep_len > 0);
+}
 
-	printf("not filtering for AXI IDs. Possible AXI masters:\n ");
+static void usage(void)
+{
+	struct axi_filter *filter;
+
+	printf("Usage: imx6_ddrstat [-h] [-d] [-S] [-s[list]] [interval] [filter]\n"
+	       "  -h		output in human readable format\n"
+	       "  -d, --dashboard	full screen live view ('q' quits)\n"
+	       "  -s, --sweep[=list]	cycle the AXI filter through a comma\n"
+	       "			separated list of masters, one per\n"
+	       "			interval ('all' means unfiltered)\n"
+	       "  -S, --simulate	use a simulated MMDC instead of /dev/mem\n"
+	       "  --sink=FORMAT[:TARGET][,every=N][,queue=N][,batch=N][,policy=P]\n"
+	       "			add an output, may be repeated. FORMAT is\n"
+	       "			text, pretty, csv, json, binary, serial,\n"
+	       "			stream, energy or web, TARGET a file or\n"
+	       "			tty, '-' for stdout, a stream URL or\n"
+	       "			[HOST:]PORT to serve the web page on, P\n"
+	       "			is drop, drop-new or block\n"
+	       "  --stream=URL		same as --sink=stream:URL, URL is\n"
+	       "			tcp://host[:port] or udp://host[:port]\n"
+	       "  --web[=[HOST:]PORT]	same as --sink=web:[HOST:]PORT, a live\n"
+	       "			chart on http://HOST:PORT/ (default 8080)\n"
+	       "  --device=NAME		device name sent with the stream\n"
+	       "  --control=PATH	accept commands on a unix socket\n"
+	       "  --align		end windows on wall clock multiples of\n"
+	       "			the interval\n"
+	       "  --correlate=SECONDS	attach a REALTIME correlation record\n"
+	       "			that often, 0 disables (default 60)\n"
+	       "  --poll=USEC		busy-poll windows of 10-100000 us and\n"
+	       "			print them as CSV once done, sinks and\n"
+	       "			the dashboard are not used\n"
+	       "  --count=N		number of --poll windows (default 10000)\n"
+	       "  --cpu=N		pin the --poll loop to an isolated CPU\n"
+	       "  --read=MODE		--poll register reads: seq, burst\n"
+	       "			(default) or freeze\n"
+	       "  --alert=TARGET[,z=N][,alpha=A][,warmup=N]\n"
+	       "			report windows deviating more than z\n"
+	       "			standard deviations from the moving\n"
+	       "			mean, TARGET is '-', syslog or\n"
+	       "			exec:COMMAND\n"
+	       "  --energy=PART[,bg=mW][,busy=pJ][,rd=pJ][,wr=pJ][,rdb=pJ][,wrb=pJ][,fps=N]\n"
+	       "			DDR power model for the energy sink, PART\n"
+	       "			is ddr3 (default) or lpddr2\n"
+	       "  --whatif=MASTER*FACTOR[,...][,limit=PERCENT]\n"
+	       "			sweep the named masters and project\n"
+	       "			busy%% and headroom with their traffic\n"
+	       "			scaled, reported on exit\n"
+	       "  --audit[=BURST]	sweep all masters and rank them by the\n"
+	       "			bandwidth lost to accesses smaller than\n"
+	       "			BURST bytes (default 64), reported on exit\n"
+	       "  --shm[=NAME]		take windows from ddrstat_helper through\n"
+	       "			shared memory instead of /dev/mem\n"
+	       "  --adaptive[=min=MS][,max=MS][,idle=PERCENT][,busy=PERCENT][,hold=N]\n"
+	       "			lengthen windows up to max while busy%%\n"
+	       "			stays below idle, drop to min once it\n"
+	       "			exceeds busy (100-4000 ms, 5%%, 20%%)\n"
+	       "  --procs[=N]		split ARM traffic across processes by\n"
+	       "			their cache misses, print the top N\n"
+	       "			(default 10) on exit\n"
+	       "  --display=CHANNEL:WxH@HZ:BPP[,...][,limit=PERCENT][,ahead=N][,tolerance=PERCENT]\n"
+	       "			warn before scanout channels run out of\n"
+	       "			bandwidth, predicting busy%% N windows\n"
+	       "			ahead against limit (default 85%%, 3)\n"
+	       "  --governor=DEVICE[,root=DIR][,up=PERCENT][,target=PERCENT][,hold=N][,floor=MASTER:MBPS]\n"
+	       "			set the DDR clock of a devfreq device\n"
+	       "			from the measured load (75%%, 60%%, 5)\n"
+	       "  --budget=MASTER[+MASTER...]:MBPS[,action=ACTION...][,windows=N][,cooldown=SECONDS]\n"
+	       "			act when the masters exceed MBPS for N\n"
+	       "			windows (default 1), at most once every\n"
+	       "			cooldown seconds (default 5); ACTION is\n"
+	       "			exec:COMMAND, cgroup:DIR:QUOTA or\n"
+	       "			signal:PID[:SIG], undone on clear\n"
+	       "  --budget-log=FILE	append budget actions to FILE instead\n"
+	       "			of stderr\n"
+	       "  --io[=FILTER=DEV[+DEV...][,...]]\n"
+	       "			compare the DDR traffic of DMA masters\n"
+	       "			to the network and disk I/O behind them,\n"
+	       "			found from sysfs unless listed\n"
+	       "  --admit[=name=NAME][,limit=PERCENT][,token=PERCENT][,critical=PERCENT][,smooth=WEIGHT][,group=GROUP]\n"
+	       "			publish the load and headroom tokens to\n"
+	       "			applications through shared memory, see\n"
+	       "			ddrstat_admit.h (70%%, 5%%, 90%%, 0.3)\n"
+	       "  --plan=FILE		run the profiling steps listed in FILE\n"
+	       "			and print a combined report\n"
+	       "  --replay=FILE[,speed=FACTOR]\n"
+	       "			take windows from a binary recording\n"
+	       "			at FACTOR times the recorded pace,\n"
+	       "			0 as fast as possible (default 1)\n"
+	       "  --skew		measure the inter-register skew of each\n"
+	       "			read mode for the --poll window and exit\n"
+	       " interval:	1-4 seconds\n"
+	       " possible AXI master filters:\n ");
 	for (filter = filters; filter->name != NULL; filter++)
 		printf(" %s", filter->name);
 	printf("\n");
-	axi_id = 0;
-	axi_id_mask = 0;
 }
 
 int main(int argc, char **argv)
 {
+	static const struct option long_options[] = {
+		{ "help",      no_argument,       NULL, 'H' },
+		{ "dashboard", no_argument,       NULL, 'd' },
+		{ "sweep",     optional_argument, NULL, 's' },
+		{ "simulate",  no_argument,       NULL, 'S' },
+		{ "stream",    required_argument, NULL, 'U' },
+		{ "sink",      required_argument, NULL, 'O' },
+		{ "device",    required_argument, NULL, 'N' },
+		{ "control",   required_argument, NULL, 'C' },
+		{ "align",     no_argument,       NULL, 'A' },
+		{ "correlate", required_argument, NULL, 'T' },
+		{ "poll",      required_argument, NULL, 'P' },
+		{ "count",     required_argument, NULL, 'K' },
+		{ "cpu",       required_argument, NULL, 'Y' },
+		{ "read",      required_argument, NULL, 'R' },
+		{ "skew",      no_argument,       NULL, 'W' },
+		{ "alert",     required_argument, NULL, 'L' },
+		{ "energy",    required_argument, NULL, 'E' },
+		{ "whatif",    required_argument, NULL, 'F' },
+		{ "audit",     optional_argument, NULL, 'B' },
+		{ "shm",       optional_argument, NULL, 'M' },
+		{ "replay",    required_argument, NULL, 'I' },
+		{ "adaptive",  optional_argument, NULL, 'D' },
+		{ "web",       optional_argument, NULL, 'G' },
+		{ "plan",      required_argument, NULL, 'Q' },
+		{ "procs",     optional_argument, NULL, 'J' },
+		{ "governor",  required_argument, NULL, 'V' },
+		{ "display",   required_argument, NULL, 'Z' },
+		{ "budget",    required_argument, NULL, 'X' },
+		{ "budget-log", required_argument, NULL, 'g' },
+		{ "admit",     optional_argument, NULL, 'a' },
+		{ "io",        optional_argument, NULL, 'i' },
+		{ NULL, 0, NULL, 0 },
+	};
+	struct perf_sample sample = { 0 };
+	struct sigaction sa;
+	bool dashboard = false;
+	bool sweeping = false;
+	const char *sweep_list = NULL;
+	const char *control = NULL;
+	const char *alert = NULL;
+	const char *governor = NULL;
+	bool whatif = false;
+	unsigned int audit_burst = 0;
+	char auto_sweep[1024];
+	const char *sink_specs[16];
+	unsigned int num_sinks = 0;
+	bool console = true;
+	bool pretty = false;
+	unsigned int poll_us = 0;
+	unsigned int poll_count = 10000;
+	int poll_cpu = -1;
+	int poll_mode = POLL_READ_BURST;
+	bool skew = false;
+	bool device = false;
+	char spec[512];
+	unsigned int i;
 	int delay = 1;
+	double secs;
+	const char *missing;
 	char *endp;
+	int c, err;
 
-	if (argc > 1 && strcmp(argv[1], "--help") == 0) {
-		struct axi_filter *filter;
-
-		printf("Usage: imx6_ddrstat [-h] [interval] [filter]\n"
-		       "  -h		output in human readable format\n"
-		       " interval:	1-4 seconds\n"
-		       " possible AXI master filters:\n ");
-		for (filter = filters; filter->name != NULL; filter++)
-			printf(" %s", filter->name);
-		printf("\n");
-		return 0;
-	}
-	if (argc > 1 && strcmp(argv[1], "-h") == 0) {
-		pretty = true;
-		argv++;
-		argc--;
+	while ((c = getopt_long(argc, argv, "+hds::S", long_options,
+				NULL)) != -1) {
+		switch (c) {
+		case 'H':
+			usage();
+			return 0;
+		case 'h':
+			pretty = true;
+			break;
+		case 'd':
+			dashboard = true;
+			break;
+		case 's':
+			sweeping = true;
+			sweep_list = optarg;
+			break;
+		case 'S':
+			simulate = true;
+			break;
+		case 'O':
+		case 'U':
+		case 'G':
+			if (num_sinks == ARRAY_SIZE(sink_specs)) {
+				fprintf(stderr, "too many sinks\n");
+				return 1;
+			}
+			if (c == 'U') {
+				snprintf(spec, sizeof(spec), "stream:%s",
+					 optarg);
+				sink_specs[num_sinks++] = strdup(spec);
+			} else if (c == 'G') {
+				snprintf(spec, sizeof(spec), "web:%s",
+					 optarg ? optarg : "");
+				sink_specs[num_sinks++] = strdup(spec);
+			} else {
+				sink_specs[num_sinks++] = optarg;
+				console = false;
+			}
+			break;
+		case 'N':
+			stream_set_device(optarg);
+			device = true;
+			break;
+		case 'C':
+			control = optarg;
+			break;
+		case 'A':
+			align = true;
+			break;
+		case 'T':
+			secs = strtod(optarg, &endp);
+			if (endp == optarg || *endp || !(secs >= 0.0) ||
+			    secs * 1000.0 > UINT_MAX) {
+				fprintf(stderr, "correlate period must be 0-%u s\n",
+					UINT_MAX / 1000);
+				return 1;
+			}
+			corr_ms = secs * 1000.0;
+			break;
+		case 'P':
+			poll_us = strtoul(optarg, NULL, 0);
+			if (poll_us < 10 || poll_us > 100000) {
+				fprintf(stderr, "poll period must be 10-100000 us\n");
+				return 1;
+			}
+			break;
+		case 'K':
+			poll_count = strtoul(optarg, NULL, 0);
+			if (!poll_count || poll_count > 10000000) {
+				fprintf(stderr, "count must be 1-10000000\n");
+				return 1;
+			}
+			break;
+		case 'Y':
+			poll_cpu = strtol(optarg, NULL, 0);
+			break;
+		case 'R':
+			poll_mode = poll_read_parse(optarg);
+			if (poll_mode < 0) {
+				fprintf(stderr, "unknown read mode '%s'\n",
+					optarg);
+				return 1;
+			}
+			break;
+		case 'W':
+			skew = true;
+			break;
+		case 'L':
+			alert = optarg;
+			break;
+		case 'E':
+			if (energy_init(optarg))
+				return 1;
+			break;
+		case 'F':
+			if (whatif_init(optarg))
+				return 1;
+			whatif = true;
+			break;
+		case 'M':
+			shm_name = optarg ? optarg : DDRSTAT_SHM_NAME;
+			break;
+		case 'D':
+			if (adapt_init(optarg))
+				return 1;
+			break;
+		case 'Z':
+			if (display_init(optarg))
+				return 1;
+			break;
+		case 'i':
+			if (io_init(optarg))
+				return 1;
+			break;
+		case 'a':
+			if (admit_init(optarg))
+				return 1;
+			break;
+		case 'X':
+			if (budget_add(optarg))
+				return 1;
+			break;
+		case 'g':
+			if (budget_log_open(optarg))
+				return 1;
+			break;
+		case 'V':
+			governor = optarg;
+			break;
+		case 'J':
+			if (procs_init(optarg))
+				return 1;
+			break;
+		case 'Q':
+			if (plan_load(optarg))
+				return 1;
+			break;
+		case 'I':
+			replay_spec = optarg;
+			break;
+		case 'B':
+			audit_burst = optarg ? strtoul(optarg, NULL, 0) : 64;
+			if (!audit_burst) {
+				fprintf(stderr, "invalid burst size\n");
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			return 1;
+		}
 	}
+	argv += optind - 1;
+	argc -= optind - 1;
+
 	if (argc > 1) {
 		delay = strtol(argv[1], &endp, 0);
 		if (delay > 4)
@@ -332,20 +982,264 @@ int main(int argc, char **argv)
 	if (argc > 2)
 		setup_axi_filter(argv[2]);
 
+	if (plan_loaded() && (sweeping || whatif || audit_burst ||
+			      adapt_enabled() || replay_spec)) {
+		fprintf(stderr, "plan steps pick their own filters and intervals\n");
+		return 1;
+	}
+
+	/* the default sweep covers every top level master for the audit */
+	if (audit_burst)
+		sweeping = true;
+
+	/* masters the analyses have to see, plan steps pick their own */
+	if (!plan_loaded() &&
+	    ((whatif && sweep_need("--whatif", whatif_sweep_list)) ||
+	     (display_enabled() &&
+	      sweep_need("--display", display_sweep_list)) ||
+	     (budget_enabled() && sweep_need("--budget", budget_sweep_list)) ||
+	     (io_enabled() && sweep_need("--io", io_sweep_list)) ||
+	     (procs_enabled() && !axi_filter &&
+	      sweep_need("--procs", procs_sweep_list))))
+		return 1;
+
+	/* without a sweep of the user's, one sweep serves them all */
+	if (!sweeping && num_sweep_needs) {
+		if (sweep_merge(auto_sweep, sizeof(auto_sweep)))
+			return 1;
+		sweep_list = auto_sweep;
+		sweeping = true;
+	}
+
+	if (sweeping) {
+		if (sweep_setup(sweep_list))
+			return 1;
+		perf_set_filter(sweep[0]);
+	}
+
+	/* a master left out would go unmeasured without a word */
+	for (i = 0; i < num_sweep_needs; i++) {
+		missing = sweep_lacks(sweep_needs[i].list);
+		if (missing) {
+			fprintf(stderr, "%s needs %s in the sweep\n",
+				sweep_needs[i].option, missing);
+			return 1;
+		}
+	}
+
 	if (delay <= 0)
 		delay = 1;
-	printf("interval %d s\n", delay);
+	interval_ms = delay * 1000;
+	if (adapt_enabled()) {
+		interval_ms = adapt_initial_ms();
+		if (!dashboard)
+			printf("adaptive interval, starting at %u ms\n",
+			       interval_ms);
+	} else if (!dashboard && !poll_us && !skew) {
+		printf("interval %d s\n", delay);
+	}
+
+	if (shm_name && (poll_us || skew)) {
+		fprintf(stderr, "--poll and --skew need direct register access\n");
+		return 1;
+	}
+
+	if (adapt_enabled() && (shm_name || replay_spec || poll_us || skew)) {
+		fprintf(stderr, "--adaptive needs to own the sampling interval\n");
+		return 1;
+	}
+
+	if (plan_loaded() && (poll_us || skew)) {
+		fprintf(stderr, "--plan cannot be combined with --poll or --skew\n");
+		return 1;
+	}
+
+	if (governor && axi_filter && !sweeping) {
+		fprintf(stderr, "--governor steers from unfiltered windows, not with a fixed filter\n");
+		return 1;
+	}
+
+	if (replay_spec && governor) {
+		fprintf(stderr, "--governor needs a live MMDC, not a recording\n");
+		return 1;
+	}
+
+	if (replay_spec && admit_enabled()) {
+		fprintf(stderr, "--admit needs a live MMDC, not a recording\n");
+		return 1;
+	}
+
+	if (replay_spec && io_enabled()) {
+		fprintf(stderr, "--io needs live I/O counters, not a recording\n");
+		return 1;
+	}
+
+	if (replay_spec && procs_enabled()) {
+		fprintf(stderr, "--procs needs live processes, not a recording\n");
+		return 1;
+	}
+
+	if (replay_spec && (shm_name || poll_us || skew || align)) {
+		fprintf(stderr, "--replay excludes --shm, --poll, --skew and --align\n");
+		return 1;
+	}
 
 	if (perf_init())
 		return 1;
 
-	for (;;) {
+	/* streams re-sent from a recording keep the recorded device name */
+	if (replay_spec && !device)
+		stream_set_device(replay_device());
+
+	if (poll_us || skew) {
+		perf_start();
+		if (skew)
+			err = poll_skew(mmdc0, simulate, poll_us ? poll_us : 100,
+					poll_count, poll_cpu);
+		else
+			err = poll_run(mmdc0, mmdc1, simulate, poll_mode,
+				       poll_us, poll_count, poll_cpu);
+		perf_stop(&sample);
+		perf_close();
+		return err ? 1 : 0;
+	}
+
+	/* a recording can wait for its sinks, live windows cannot */
+	if (replay_spec)
+		sinks_set_policy(SINK_BLOCK);
+
+	/* without explicit sinks, print to the console as always */
+	if (console && !dashboard && sink_add(pretty ? "pretty" : "text"))
+		goto err;
+	for (i = 0; i < num_sinks; i++)
+		if (sink_add(sink_specs[i]))
+			goto err;
+
+	if (control && ctrl_init(control))
+		goto err;
+
+	if (alert && alert_init(alert))
+		goto err;
+
+	if (governor && gov_init(governor, simulate))
+		goto err;
+
+	if (admit_open(interval_ms))
+		goto err;
+
+	if (dashboard && alert_to_stdout()) {
+		fprintf(stderr, "alerts to stdout would garble the dashboard\n");
+		goto err;
+	}
+
+	if (dashboard && display_enabled()) {
+		fprintf(stderr, "display warnings on stdout would garble the dashboard\n");
+		goto err;
+	}
+
+	if (dashboard && budget_log_to_console()) {
+		fprintf(stderr, "--budget with --dashboard needs --budget-log\n");
+		goto err;
+	}
+
+	if (dashboard && governor) {
+		fprintf(stderr, "frequency changes on stderr would garble the dashboard\n");
+		goto err;
+	}
+
+	if (dashboard && dashboard_init(interval_ms, sweeping))
+		goto err;
+
+	/* the dashboard has its own handlers, which also restore the tty */
+	if (!dashboard) {
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_handler = on_signal;
+		sigaction(SIGINT, &sa, NULL);
+		sigaction(SIGTERM, &sa, NULL);
+	}
+
+	if (plan_loaded() && plan_next(delay * 1000, dashboard))
+		quit = 1;
+
+	if (align && !quit) {
+		align_next_boundary();
+		align_wait();
+	}
+
+	while (!quit) {
 		perf_start();
-		sleep(delay);
-		perf_stop();
-		perf_print();
+		if (align)
+			align_next_boundary();
+		if (replay_spec) {
+			if (perf_replay_wait(dashboard))
+				break;
+		} else if (shm) {
+			if (perf_shm_wait(dashboard))
+				break;
+		} else if (dashboard) {
+			if (dashboard_wait(align ? align_remaining_ms() :
+					   interval_ms) < 0)
+				break;
+		} else {
+			if (align)
+				align_wait();
+			else
+				perf_wait(interval_ms);
+			if (quit)
+				break;
+		}
+		perf_stop(&sample);
+		sinks_push(&sample);
+		if (dashboard)
+			dashboard_update(&sample);
+		perf_account(&sample);
+		alert_check(windows, &sample);
+		display_check(windows, &sample);
+		budget_check(&sample);
+		admit_update(&sample, interval_ms);
+		whatif_account(&sample);
+		procs_account(&sample);
+		io_account(&sample);
+		gov_update(&sample);
+		sweep_next();
+		if (plan_account(&sample)) {
+			plan_end();
+			if (plan_next(delay * 1000, dashboard))
+				break;
+		}
+		if (adapt_enabled())
+			adapt_interval(&sample, dashboard);
+		control_apply(&sample, dashboard);
+		reap_hooks();
 	}
 
+	if (dashboard)
+		dashboard_exit();
+	plan_end();
+	gov_exit();
+	admit_exit();
+	budget_exit();
+	alert_exit();
+	ctrl_exit();
+	sinks_exit();
+	whatif_report(stdout);
+	plan_report(stdout);
+	procs_report(stdout);
+	io_report(stdout);
+	display_report(stdout);
+	admit_report(stdout);
+	adapt_report(stdout);
+	if (audit_burst)
+		audit_report(stdout, totals, ARRAY_SIZE(totals), audit_burst);
 	perf_close();
 	return 0;
+err:
+	gov_exit();
+	admit_exit();
+	budget_exit();
+	alert_exit();
+	ctrl_exit();
+	sinks_exit();
+	perf_close();
+	return 1;
 }
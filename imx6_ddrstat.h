@@ -0,0 +1,393 @@
+/*
+ * Copyright (c) 2012 Philipp Zabel
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef IMX6_DDRSTAT_H
+#define IMX6_DDRSTAT_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+#define PAGE_SIZE 4096
+
+#define MMDC0_BASE 0x021b0000
+#define MMDC1_BASE 0x021b4000
+
+#define MMDC_MADPCR0 0x0410
+#define MMDC_MADPCR1 0x0414
+#define MMDC_MADPSR0 0x0418	/* total cycles */
+#define MMDC_MADPSR1 0x041c	/* busy cycles */
+#define MMDC_MADPSR2 0x0420	/* total read accesses */
+#define MMDC_MADPSR3 0x0424	/* total write accesses */
+#define MMDC_MADPSR4 0x0428	/* total read bytes */
+#define MMDC_MADPSR5 0x042c	/* total write bytes */
+
+#define MADPCR0_DBG_EN	(1 << 0)
+#define MADPCR0_DBG_RST	(1 << 1)
+#define MADPCR0_PRF_FRZ	(1 << 2)
+#define MADPCR0_CYC_OVF	(1 << 3)
+
+#define MADPCR1_PRF_AXI_ID_SHIFT	0	/* profiling AXI ID */
+#define MADPCR1_PRF_AXI_ID_MASK_SHIFT	16	/* profiling AXI ID mask */
+
+/*
+ * AXI IDs that match
+ * (AXI-ID & PRF_AXI_ID_MASK) Xnor (PRF_AXI_ID & PRF_AXI_ID_MASK)
+ * are taken for profiling
+ *
+ * To monitor AXI ID's between A100 till A1FF, use
+ * - PRF_AXI_ID= 0xa100
+ * - PRF_AXI_ID_MASK = 0xff00
+ */
+
+struct mmdc_stats {
+	uint32_t cycles;
+	uint32_t busy_cycles;
+	uint32_t read_accesses;
+	uint32_t write_accesses;
+	uint32_t read_bytes;
+	uint32_t write_bytes;
+};
+
+struct axi_filter {
+	char *name;
+	unsigned short axi_id_mask;
+	unsigned short axi_id;
+};
+
+/* NULL terminated, see Table 43-8 of the reference manual */
+extern struct axi_filter filters[];
+
+/*
+ * CLOCK_REALTIME, CLOCK_MONOTONIC_RAW and CLOCK_BOOTTIME read as close
+ * together as possible, to map window timestamps to wall clock time.
+ * The raw clock is read before and after the other two; raw_ns is the
+ * midpoint and uncertainty_ns the distance between both reads.
+ */
+struct clock_corr {
+	uint64_t realtime_ns;
+	uint64_t raw_ns;
+	uint64_t boot_ns;
+	uint32_t uncertainty_ns;
+};
+
+/*
+ * One profiling window: the frozen counters of both controllers plus
+ * the AXI filter that was active while they were counting (NULL if the
+ * window was not filtered). Start and end are CLOCK_MONOTONIC_RAW and
+ * CLOCK_BOOTTIME timestamps; every now and then a window also carries
+ * a clock correlation record. If the system was suspended during the
+ * window, suspended_ns says for how long and the counters are not to
+ * be trusted.
+ */
+struct perf_sample {
+	struct mmdc_stats mmdc[2];
+	const struct axi_filter *filter;
+	bool sweep;		/* the filter was picked by a sweep */
+	uint64_t duration_ns;
+	uint64_t start_raw_ns;
+	uint64_t end_raw_ns;
+	uint64_t start_boot_ns;
+	uint64_t end_boot_ns;
+	uint64_t suspended_ns;
+	bool has_corr;
+	struct clock_corr corr;
+};
+
+/* Counters accumulated over many windows */
+struct mmdc_totals {
+	uint64_t cycles;
+	uint64_t busy_cycles;
+	uint64_t read_accesses;
+	uint64_t write_accesses;
+	uint64_t read_bytes;
+	uint64_t write_bytes;
+};
+
+struct perf_totals {
+	uint64_t windows;
+	uint64_t duration_ns;
+	struct mmdc_totals mmdc[2];
+};
+
+/* Commands received on the control socket during one window */
+struct ctrl_request {
+	bool set_filter;
+	const struct axi_filter *filter;
+	bool set_interval;
+	unsigned int interval_ms;
+	bool sweep_start;
+	char sweep_list[256];
+	bool sweep_stop;
+	bool reset;
+	bool snapshot;
+};
+
+static inline double mmdc_busy(const struct mmdc_stats *st)
+{
+	return st->cycles ? 100.0 * st->busy_cycles / st->cycles : 0.0;
+}
+
+static inline void perf_totals_add(struct perf_totals *t,
+				   const struct perf_sample *s)
+{
+	int c;
+
+	t->windows++;
+	t->duration_ns += s->duration_ns;
+	for (c = 0; c < 2; c++) {
+		t->mmdc[c].cycles += s->mmdc[c].cycles;
+		t->mmdc[c].busy_cycles += s->mmdc[c].busy_cycles;
+		t->mmdc[c].read_accesses += s->mmdc[c].read_accesses;
+		t->mmdc[c].write_accesses += s->mmdc[c].write_accesses;
+		t->mmdc[c].read_bytes += s->mmdc[c].read_bytes;
+		t->mmdc[c].write_bytes += s->mmdc[c].write_bytes;
+	}
+}
+
+/* bytes per second, using the measured window length */
+static inline double perf_rate(const struct perf_sample *s, uint32_t bytes)
+{
+	return s->duration_ns ? bytes * 1e9 / s->duration_ns : 0.0;
+}
+
+/* admit.c */
+int admit_init(const char *spec);
+bool admit_enabled(void);
+int admit_open(unsigned int interval_ms);
+void admit_update(const struct perf_sample *s, unsigned int interval_ms);
+void admit_exit(void);
+void admit_report(FILE *f);
+
+/* adapt.c */
+int adapt_init(const char *spec);
+bool adapt_enabled(void);
+unsigned int adapt_initial_ms(void);
+unsigned int adapt_next(const struct perf_sample *s, unsigned int interval_ms);
+void adapt_report(FILE *f);
+
+/* alert.c */
+int alert_init(const char *spec);
+bool alert_to_stdout(void);
+void alert_check(uint64_t window, const struct perf_sample *s);
+void alert_exit(void);
+
+/* audit.c */
+void audit_report(FILE *f, const struct perf_totals *totals,
+		  unsigned int num, unsigned int burst);
+
+/* budget.c */
+int budget_add(const char *spec);
+bool budget_enabled(void);
+bool budget_log_to_console(void);
+int budget_log_open(const char *path);
+int budget_sweep_list(char *buf, size_t size);
+void budget_check(const struct perf_sample *s);
+void budget_exit(void);
+
+/* axi_filters.c */
+const struct axi_filter *axi_filter_find(const char *name);
+const struct axi_filter *axi_filter_lookup(unsigned short axi_id,
+					   unsigned short axi_id_mask);
+bool axi_filter_is_toplevel(const struct axi_filter *filter);
+bool axi_id_matches(unsigned short axi_id, unsigned short filter_id,
+		    unsigned short filter_mask);
+
+/* procs.c */
+int procs_init(const char *spec);
+bool procs_enabled(void);
+int procs_sweep_list(char *buf, size_t size);
+void procs_account(const struct perf_sample *s);
+void procs_report(FILE *f);
+
+/* replay.c */
+int replay_open(const char *spec);
+const char *replay_device(void);
+int replay_next(struct perf_sample *s, unsigned int *delay_ms);
+void replay_close(void);
+
+/* sim.c */
+void *sim_map(unsigned int base);
+void sim_unmap(void *mem);
+void sim_reset(volatile uint32_t *mmdc);
+void sim_update(volatile uint32_t *mmdc);
+void sim_set_clock(double hz);
+
+/* gov.c */
+int gov_init(const char *spec, bool simulate);
+bool gov_enabled(void);
+void gov_update(const struct perf_sample *s);
+void gov_exit(void);
+
+/* iodma.c */
+int io_init(const char *spec);
+bool io_enabled(void);
+int io_sweep_list(char *buf, size_t size);
+void io_account(const struct perf_sample *s);
+void io_report(FILE *f);
+
+/* mmdc.c */
+void *mmdc_map(int fd, unsigned int base, bool simulate);
+void mmdc_unmap(void *mem, bool simulate);
+void mmdc_arm(volatile uint32_t *mmdc, unsigned short axi_id,
+	      unsigned short axi_id_mask);
+void mmdc_set_filter(volatile uint32_t *mmdc, unsigned short axi_id,
+		     unsigned short axi_id_mask);
+void mmdc_start(volatile uint32_t *mmdc, bool simulate);
+bool mmdc_stop(volatile uint32_t *mmdc, bool simulate, struct mmdc_stats *st);
+
+/* plan.c */
+struct plan_step {
+	char *name;
+	const struct axi_filter *filter;
+	bool sweep;
+	char *sweep_list;		/* NULL for the default sweep */
+	unsigned int interval_ms;	/* 0 keeps the command line interval */
+	unsigned int duration_ms;	/* 0 runs until the command exits */
+	char *run;
+	char *output;			/* sink spec */
+};
+
+int plan_load(const char *path);
+bool plan_loaded(void);
+const struct plan_step *plan_begin(void);
+bool plan_account(const struct perf_sample *s);
+void plan_end(void);
+void plan_report(FILE *f);
+
+/* poll.c */
+enum poll_read_mode {
+	POLL_READ_SEQ,		/* one register after the other */
+	POLL_READ_BURST,	/* MADPSR0-5 in one load multiple */
+	POLL_READ_FREEZE,	/* burst read with the counters frozen */
+};
+
+int poll_read_parse(const char *name);
+int poll_run(void *mmdc0, void *mmdc1, bool simulate,
+	     enum poll_read_mode mode, unsigned int period_us,
+	     unsigned int count, int cpu);
+int poll_skew(void *mmdc0, bool simulate, unsigned int period_us,
+	      unsigned int count, int cpu);
+
+/* sink.c */
+struct sink;
+
+struct sink_ops {
+	const char *format;
+	int (*open)(struct sink *sk);
+	/* n samples from seq on, < 0 keeps them queued for a retry */
+	int (*write)(struct sink *sk, uint32_t seq,
+		     const struct perf_sample *s, unsigned int n);
+	void (*close)(struct sink *sk);
+};
+
+enum sink_policy {
+	SINK_DROP,		/* drop the oldest queued sample */
+	SINK_DROP_NEW,		/* drop the sample being pushed */
+	SINK_BLOCK,		/* hold the sampler until there is room */
+};
+
+struct sink {
+	const struct sink_ops *ops;
+	char *target;
+	FILE *f;
+	void *priv;
+	unsigned int every;
+	unsigned int queue;
+	unsigned int batch;
+	enum sink_policy policy;
+
+	/* queue state, protected by lock */
+	struct perf_sample *ring;
+	uint32_t head, tail;
+	uint64_t seen;
+	uint64_t dropped;
+	bool running;
+	pthread_mutex_t lock;
+	pthread_cond_t more;
+	pthread_cond_t space;
+	pthread_t thread;
+	struct sink *next;
+};
+
+void sinks_set_policy(enum sink_policy policy);
+int sink_add(const char *spec);
+bool sinks_active(void);
+unsigned int sinks_count(void);
+void sinks_trim(unsigned int keep);
+void sinks_push(const struct perf_sample *s);
+void sinks_interrupt(void);
+void sinks_exit(void);
+
+/* display.c */
+int display_init(const char *spec);
+bool display_enabled(void);
+int display_sweep_list(char *buf, size_t size);
+void display_check(uint64_t window, const struct perf_sample *s);
+void display_report(FILE *f);
+
+/* energy.c */
+int energy_init(const char *spec);
+double energy_mmdc_mw(const struct perf_sample *s, int c);
+int energy_open(struct sink *sk);
+int energy_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+		 unsigned int n);
+void energy_close(struct sink *sk);
+
+/* stream.c */
+void stream_set_device(const char *name);
+const char *stream_device(void);
+int stream_open(struct sink *sk);
+int stream_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+		 unsigned int n);
+void stream_close(struct sink *sk);
+
+/* web.c */
+int web_open(struct sink *sk);
+int web_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+	      unsigned int n);
+void web_close(struct sink *sk);
+
+/* ctrl.c */
+int ctrl_init(const char *path);
+bool ctrl_take(struct ctrl_request *req);
+void ctrl_done(char *snapshot);
+void ctrl_exit(void);
+
+/* dashboard.c */
+int dashboard_init(unsigned int interval_ms, bool sweeping);
+void dashboard_configure(unsigned int interval_ms, bool sweeping);
+int dashboard_wait(unsigned int ms);
+void dashboard_update(const struct perf_sample *s);
+void dashboard_exit(void);
+
+/* whatif.c */
+int whatif_init(const char *spec);
+int whatif_sweep_list(char *buf, size_t size);
+void whatif_account(const struct perf_sample *s);
+void whatif_report(FILE *f);
+
+#endif
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * I/O DMA amplification. The DMA masters move payload between DDR and
+ * a device, plus whatever the driver adds: descriptor rings, status
+ * write-backs, copies through bounce buffers. Their filtered windows
+ * are set against the I/O the kernel counted on the devices behind
+ * them over the same window, from /sys/class/net/<if>/statistics and
+ * /proc/diskstats, which are read after every window.
+ *
+ * --io[=FILTER=DEV[+DEV...][,...]]
+ *
+ * Without a list, network interfaces and block devices are matched to
+ * enet, usdhc1-4, sata, usb and pcie by the controller in their sysfs
+ * path. Inbound I/O (received packets, sectors read) is DMA written to
+ * DDR, outbound I/O is DMA read from it, so the report compares DDR
+ * writes to the former and DDR reads to the latter: bytes per payload
+ * byte, and bytes beyond the payload per packet or request. Ratios
+ * well above 1 point at descriptor thrashing on small packets or at
+ * buffers copied once more.
+ */
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "imx6_ddrstat.h"
+
+#define IO_MAX_DEVS	8
+
+struct io_dev {
+	char name[32];
+	bool block;
+	bool valid;		/* last holds a reading */
+	uint64_t last[4];	/* in bytes, out bytes, in ops, out ops */
+	uint64_t delta[4];
+};
+
+struct io_master {
+	const struct axi_filter *filter;
+	unsigned int devs[IO_MAX_DEVS];	/* index into devs[] */
+	unsigned int num_devs;
+
+	uint64_t windows;
+	uint64_t ddr_write, ddr_read;
+	uint64_t io[4];
+};
+
+/* controllers as they appear in the device path of their children */
+static const struct {
+	const char *filter;
+	const char *path;
+} controllers[] = {
+	{ "enet", "2188000.ethernet" },
+	{ "usdhc1", "2190000.mmc" },
+	{ "usdhc1", "2190000.usdhc" },
+	{ "usdhc2", "2194000.mmc" },
+	{ "usdhc2", "2194000.usdhc" },
+	{ "usdhc3", "2198000.mmc" },
+	{ "usdhc3", "2198000.usdhc" },
+	{ "usdhc4", "219c000.mmc" },
+	{ "usdhc4", "219c000.usdhc" },
+	{ "sata", "2200000.sata" },
+	{ "usb", "ci_hdrc" },
+	{ "pcie", "1ffc000.pcie" },
+};
+
+static bool enabled;
+static struct io_dev devs[32];
+static unsigned int num_devs;
+static struct io_master masters[16];
+static unsigned int num_masters;
+
+static int io_dev_add(const char *name, bool block)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_devs; i++)
+		if (strcmp(devs[i].name, name) == 0)
+			return i;
+	if (num_devs == ARRAY_SIZE(devs) || strlen(name) >= sizeof(devs[0].name))
+		return -1;
+	strcpy(devs[num_devs].name, name);
+	devs[num_devs].block = block;
+	return num_devs++;
+}
+
+static struct io_master *io_master_get(const struct axi_filter *filter)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_masters; i++)
+		if (masters[i].filter == filter)
+			return &masters[i];
+	if (num_masters == ARRAY_SIZE(masters))
+		return NULL;
+	masters[num_masters].filter = filter;
+	return &masters[num_masters++];
+}
+
+static int io_map(const struct axi_filter *filter, const char *name,
+		  bool block)
+{
+	struct io_master *m = io_master_get(filter);
+	int d = io_dev_add(name, block);
+	unsigned int i;
+
+	if (!m || d < 0)
+		return -1;
+	for (i = 0; i < m->num_devs; i++)
+		if (m->devs[i] == (unsigned int)d)
+			return 0;
+	if (m->num_devs == IO_MAX_DEVS)
+		return -1;
+	m->devs[m->num_devs++] = d;
+	return 0;
+}
+
+static bool io_is_net(const char *name)
+{
+	char path[PATH_MAX];
+
+	snprintf(path, sizeof(path), "/sys/class/net/%s/statistics", name);
+	return access(path, R_OK) == 0;
+}
+
+/* Map the devices in one sysfs class directory by their device path */
+static void io_discover(const char *dir, bool block)
+{
+	char path[PATH_MAX], real[PATH_MAX];
+	struct dirent *de;
+	unsigned int i;
+	DIR *d;
+
+	d = opendir(dir);
+	if (!d)
+		return;
+	while ((de = readdir(d))) {
+		if (de->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+		if (!realpath(path, real))
+			continue;
+		for (i = 0; i < ARRAY_SIZE(controllers); i++) {
+			if (!strstr(real, controllers[i].path))
+				continue;
+			io_map(axi_filter_find(controllers[i].filter),
+			       de->d_name, block);
+			break;
+		}
+	}
+	closedir(d);
+}
+
+static int io_parse(char *spec)
+{
+	const struct axi_filter *filter;
+	char *map, *dev, *eq, *saveptr, *saveptr2;
+
+	for (map = strtok_r(spec, ",", &saveptr); map;
+	     map = strtok_r(NULL, ",", &saveptr)) {
+		eq = strchr(map, '=');
+		if (!eq)
+			return -1;
+		*eq = '\0';
+		filter = axi_filter_find(map);
+		if (!filter)
+			return -1;
+		for (dev = strtok_r(eq + 1, "+", &saveptr2); dev;
+		     dev = strtok_r(NULL, "+", &saveptr2))
+			if (io_map(filter, dev, !io_is_net(dev)))
+				return -1;
+	}
+	return 0;
+}
+
+/* Read the counters of every device, return 0 if all were found */
+static int io_read(void)
+{
+	char path[PATH_MAX], line[256], name[32];
+	static const char *const stats[] = {
+		"rx_bytes", "tx_bytes", "rx_packets", "tx_packets",
+	};
+	unsigned long long v[4], rd, rd_sect, wr, wr_sect;
+	unsigned int i, j;
+	bool found[ARRAY_SIZE(devs)] = { false };
+	FILE *f;
+	int err = 0;
+
+	for (i = 0; i < num_devs; i++) {
+		if (devs[i].block)
+			continue;
+		for (j = 0; j < 4; j++) {
+			snprintf(path, sizeof(path),
+				 "/sys/class/net/%s/statistics/%s",
+				 devs[i].name, stats[j]);
+			f = fopen(path, "r");
+			if (!f || fscanf(f, "%llu", &v[j]) != 1)
+				break;
+			fclose(f);
+		}
+		if (j < 4) {
+			if (f)
+				fclose(f);
+			continue;
+		}
+		found[i] = true;
+		for (j = 0; j < 4; j++) {
+			/* counters start over when a driver is reloaded */
+			devs[i].delta[j] = devs[i].valid && v[j] >= devs[i].last[j] ?
+					   v[j] - devs[i].last[j] : 0;
+			devs[i].last[j] = v[j];
+		}
+	}
+
+	f = fopen("/proc/diskstats", "r");
+	while (f && fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "%*u %*u %31s %llu %*u %llu %*u %llu %*u %llu",
+			   name, &rd, &rd_sect, &wr, &wr_sect) != 5)
+			continue;
+		for (i = 0; i < num_devs; i++) {
+			if (!devs[i].block || strcmp(devs[i].name, name))
+				continue;
+			found[i] = true;
+			v[0] = rd_sect * 512;
+			v[1] = wr_sect * 512;
+			v[2] = rd;
+			v[3] = wr;
+			for (j = 0; j < 4; j++) {
+				devs[i].delta[j] = devs[i].valid &&
+						   v[j] >= devs[i].last[j] ?
+						   v[j] - devs[i].last[j] : 0;
+				devs[i].last[j] = v[j];
+			}
+		}
+	}
+	if (f)
+		fclose(f);
+
+	for (i = 0; i < num_devs; i++) {
+		devs[i].valid = found[i];
+		if (!found[i]) {
+			memset(devs[i].delta, 0, sizeof(devs[i].delta));
+			err = -1;
+		}
+	}
+	return err;
+}
+
+int io_init(const char *spec)
+{
+	char *copy;
+	unsigned int i, j;
+
+	enabled = true;
+	if (spec) {
+		copy = strdup(spec);
+		if (!copy || io_parse(copy)) {
+			fprintf(stderr, "invalid I/O mapping '%s'\n", spec);
+			free(copy);
+			return -1;
+		}
+		free(copy);
+	} else {
+		io_discover("/sys/class/net", false);
+		io_discover("/sys/block", true);
+	}
+
+	if (!num_masters) {
+		fprintf(stderr, "no network or block devices behind enet, usdhc, sata, usb or pcie\n");
+		return -1;
+	}
+	if (io_read()) {
+		for (i = 0; i < num_devs; i++)
+			if (!devs[i].valid)
+				fprintf(stderr, "no I/O statistics for %s\n",
+					devs[i].name);
+		return -1;
+	}
+
+	for (i = 0; i < num_masters; i++) {
+		printf("%s:", masters[i].filter->name);
+		for (j = 0; j < masters[i].num_devs; j++)
+			printf(" %s", devs[masters[i].devs[j]].name);
+		printf("\n");
+	}
+	return 0;
+}
+
+bool io_enabled(void)
+{
+	return enabled;
+}
+
+int io_sweep_list(char *buf, size_t size)
+{
+	size_t len = 0;
+	unsigned int i;
+
+	buf[0] = '\0';
+	for (i = 0; i < num_masters && len < size; i++)
+		len += snprintf(buf + len, size - len, "%s%s", len ? "," : "",
+				masters[i].filter->name);
+	return len < size ? 0 : -1;
+}
+
+void io_account(const struct perf_sample *s)
+{
+	struct io_master *m = NULL;
+	unsigned int i, j, c;
+
+	if (!enabled)
+		return;
+
+	/* every window, so the next one starts from fresh counters */
+	io_read();
+
+	for (i = 0; i < num_masters; i++)
+		if (masters[i].filter == s->filter)
+			m = &masters[i];
+	if (!m || s->suspended_ns)
+		return;
+
+	m->windows++;
+	for (c = 0; c < 2; c++) {
+		m->ddr_write += s->mmdc[c].write_bytes;
+		m->ddr_read += s->mmdc[c].read_bytes;
+	}
+	for (i = 0; i < m->num_devs; i++)
+		for (j = 0; j < 4; j++)
+			m->io[j] += devs[m->devs[i]].delta[j];
+}
+
+static void io_report_dir(FILE *f, const char *master, const char *dir,
+			  uint64_t ddr, uint64_t payload, uint64_t ops)
+{
+	fprintf(f, "%-8s %-4s %10.2f %10.2f", master, dir, ddr / 1e6,
+		payload / 1e6);
+	if (payload)
+		fprintf(f, " %9.2f", (double)ddr / payload);
+	else
+		fprintf(f, " %9s", "-");
+	if (ops)
+		fprintf(f, " %10.0f %10.0f\n", (double)payload / ops,
+			((double)ddr - payload) / ops);
+	else
+		fprintf(f, " %10s %10s\n", "-", "-");
+}
+
+void io_report(FILE *f)
+{
+	struct io_master *m;
+	unsigned int i;
+
+	if (!enabled)
+		return;
+
+	fprintf(f, "I/O DMA amplification (in: DDR writes, out: DDR reads)\n");
+	fprintf(f, "%-8s %-4s %10s %10s %9s %10s %10s\n", "MASTER", "DIR",
+		"DDR MB", "PAYLOAD MB", "DDR/BYTE", "BYTES/OP", "EXTRA/OP");
+	for (i = 0; i < num_masters; i++) {
+		m = &masters[i];
+		if (!m->windows) {
+			fprintf(f, "%-8s no windows\n", m->filter->name);
+			continue;
+		}
+		io_report_dir(f, m->filter->name, "in", m->ddr_write, m->io[0],
+			      m->io[2]);
+		io_report_dir(f, m->filter->name, "out", m->ddr_read, m->io[1],
+			      m->io[3]);
+	}
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2012 Philipp Zabel
+ * based on omap4_ddrstat.c,
+ * Copyright (c) 2010 Mans Rullgard
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * MMDC profiling register access, shared by the sampler and the
+ * privileged helper. mmdc points to the mapped register page of one
+ * controller; with simulate, to the page of the simulated MMDC.
+ */
+
+#include <sys/mman.h>
+
+#include "imx6_ddrstat.h"
+
+void *mmdc_map(int fd, unsigned int base, bool simulate)
+{
+	void *mem = simulate ? sim_map(base) :
+		    mmap(NULL, PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_SHARED, fd,
+			 base);
+
+	return mem == MAP_FAILED ? NULL : mem;
+}
+
+void mmdc_unmap(void *mem, bool simulate)
+{
+	if (simulate)
+		sim_unmap(mem);
+	else
+		munmap(mem, PAGE_SIZE);
+}
+
+/* Reset and enable profiling, with the counters frozen */
+void mmdc_arm(volatile uint32_t *mmdc, unsigned short axi_id,
+	      unsigned short axi_id_mask)
+{
+	mmdc[MMDC_MADPCR0 >> 2] = 0;
+	/* assert DBG_RST, write 1 to clear CYC_OVF */
+	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_RST | MADPCR0_CYC_OVF;
+	/* deassert DBG_RST, enable DBG_EN and set PRF_FRZ */
+	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN | MADPCR0_PRF_FRZ;
+
+	mmdc_set_filter(mmdc, axi_id, axi_id_mask);
+}
+
+void mmdc_set_filter(volatile uint32_t *mmdc, unsigned short axi_id,
+		     unsigned short axi_id_mask)
+{
+	mmdc[MMDC_MADPCR1 >> 2] = (axi_id_mask << MADPCR1_PRF_AXI_ID_MASK_SHIFT)
+				| (axi_id << MADPCR1_PRF_AXI_ID_SHIFT);
+}
+
+void mmdc_start(volatile uint32_t *mmdc, bool simulate)
+{
+	/* Assert reset, clear overflow flag */
+	mmdc[MMDC_MADPCR0 >> 2] |= MADPCR0_DBG_RST | MADPCR0_CYC_OVF;
+	mmdc[MMDC_MADPCR0 >> 2] &= ~(MADPCR0_DBG_RST | MADPCR0_PRF_FRZ);
+	if (simulate)
+		sim_reset(mmdc);
+}
+
+/* Freeze and read the counters, returns true if the cycle counter overflowed */
+bool mmdc_stop(volatile uint32_t *mmdc, bool simulate, struct mmdc_stats *st)
+{
+	if (simulate)
+		sim_update(mmdc);
+	mmdc[MMDC_MADPCR0 >> 2] |= MADPCR0_PRF_FRZ;
+
+	st->cycles         = mmdc[MMDC_MADPSR0 >> 2];
+	st->busy_cycles    = mmdc[MMDC_MADPSR1 >> 2];
+	st->read_accesses  = mmdc[MMDC_MADPSR2 >> 2];
+	st->write_accesses = mmdc[MMDC_MADPSR3 >> 2];
+	st->read_bytes     = mmdc[MMDC_MADPSR4 >> 2];
+	st->write_bytes    = mmdc[MMDC_MADPSR5 >> 2];
+
+	return mmdc[MMDC_MADPCR0 >> 2] & MADPCR0_CYC_OVF;
+}
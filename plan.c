@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Plan files, a sequence of profiling steps run by one process with the
+ * MMDC set up once, followed by a combined report. One step per line:
+ *
+ *   # nightly run
+ *   step name=idle duration=30
+ *   step name=video sweep=vpu-prime,ipu1,arm-s0 interval=0.5 run="gst-play-1.0 clip.mp4"
+ *   step name=gpu filter=gpu3d-a duration=60 run="glmark2-es2" output=csv:gpu.csv
+ *
+ *   name       label in the report (default step<N>)
+ *   filter     AXI master to count, unfiltered by default
+ *   sweep      cycle through masters, without a list the default sweep
+ *   interval   window length in seconds, 0.001-4 (default from the
+ *              command line)
+ *   duration   step length in seconds
+ *   run        shell command started with the step; without a duration
+ *              the step lasts until it exits, otherwise it is terminated
+ *              when the step ends
+ *   output     an extra --sink for the windows of this step only
+ *
+ * Values with spaces are quoted. Steps end on window boundaries.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "imx6_ddrstat.h"
+
+#define PLAN_KILL_MS	2000
+
+struct plan_result {
+	struct perf_totals totals[64];
+	uint64_t windows;
+	uint64_t elapsed_ns;
+	bool ran;
+	bool killed;
+	int status;
+};
+
+static struct plan_step *steps;
+static struct plan_result *results;
+static unsigned int num_steps;
+static unsigned int cur;	/* step running, num_steps once all are done */
+static bool started;
+
+static pid_t child;
+static unsigned int keep_sinks;
+
+/* Split a line into words, honoring single and double quotes */
+static int plan_split(char *line, char **words, unsigned int max)
+{
+	unsigned int n = 0;
+	char *in = line, *out = line;
+	char quote;
+
+	for (;;) {
+		while (*in == ' ' || *in == '\t')
+			in++;
+		if (!*in || *in == '#')
+			break;
+		if (n == max)
+			return -1;
+		words[n++] = out;
+		quote = 0;
+		while (*in && (quote || (*in != ' ' && *in != '\t'))) {
+			if (!quote && (*in == '"' || *in == '\''))
+				quote = *in++;
+			else if (quote && *in == quote) {
+				quote = 0;
+				in++;
+			} else
+				*out++ = *in++;
+		}
+		if (quote)
+			return -1;
+		if (*in)
+			in++;
+		*out++ = '\0';
+	}
+	return n;
+}
+
+static int plan_seconds_ms(const char *val, double max, unsigned int *ms)
+{
+	char *end;
+	double v = strtod(val, &end);
+
+	if (*end || v <= 0.0 || (max && v > max))
+		return -1;
+	*ms = v * 1000.0 + 0.5;
+	return *ms ? 0 : -1;
+}
+
+static int plan_word(struct plan_step *st, const char *word)
+{
+	const char *val = strchr(word, '=');
+	char *name, *saveptr, *list;
+
+	if (strcmp(word, "sweep") == 0) {
+		st->sweep = true;
+		return 0;
+	}
+	if (!val || !val[1])
+		return -1;
+	val++;
+
+	if (strncmp(word, "name=", 5) == 0) {
+		st->name = strdup(val);
+	} else if (strncmp(word, "filter=", 7) == 0) {
+		if (strcmp(val, "all") == 0)
+			return 0;
+		st->filter = axi_filter_find(val);
+		if (!st->filter)
+			return -1;
+	} else if (strncmp(word, "sweep=", 6) == 0) {
+		/* checked here so a typo fails before anything runs */
+		list = strdup(val);
+		if (!list)
+			return -1;
+		for (name = strtok_r(list, ",", &saveptr); name;
+		     name = strtok_r(NULL, ",", &saveptr)) {
+			if (strcmp(name, "all") && !axi_filter_find(name)) {
+				free(list);
+				return -1;
+			}
+		}
+		free(list);
+		st->sweep = true;
+		st->sweep_list = strdup(val);
+	} else if (strncmp(word, "interval=", 9) == 0) {
+		return plan_seconds_ms(val, 4.0, &st->interval_ms);
+	} else if (strncmp(word, "duration=", 9) == 0) {
+		return plan_seconds_ms(val, 0.0, &st->duration_ms);
+	} else if (strncmp(word, "run=", 4) == 0) {
+		st->run = strdup(val);
+	} else if (strncmp(word, "output=", 7) == 0) {
+		st->output = strdup(val);
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+int plan_load(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	struct plan_step *st;
+	char line[4096], name[32];
+	char *words[32];
+	unsigned int lineno = 0;
+	int n, i;
+
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		lineno++;
+		line[strcspn(line, "\r\n")] = '\0';
+		n = plan_split(line, words, ARRAY_SIZE(words));
+		if (n == 0)
+			continue;
+		if (n < 0 || strcmp(words[0], "step"))
+			goto bad;
+
+		st = realloc(steps, (num_steps + 1) * sizeof(*steps));
+		if (!st)
+			goto err;
+		steps = st;
+		st = &steps[num_steps];
+		memset(st, 0, sizeof(*st));
+
+		for (i = 1; i < n; i++)
+			if (plan_word(st, words[i]))
+				goto bad;
+		if (st->filter && st->sweep)
+			goto bad;
+		if (!st->duration_ms && !st->run) {
+			fprintf(stderr, "%s:%u: step needs a duration or a command\n",
+				path, lineno);
+			goto err;
+		}
+		if (!st->name) {
+			snprintf(name, sizeof(name), "step%u", num_steps + 1);
+			st->name = strdup(name);
+		}
+		num_steps++;
+	}
+	fclose(f);
+
+	if (!num_steps) {
+		fprintf(stderr, "%s: no steps\n", path);
+		return -1;
+	}
+	results = calloc(num_steps, sizeof(*results));
+	return results ? 0 : -1;
+bad:
+	fprintf(stderr, "%s:%u: invalid step\n", path, lineno);
+err:
+	fclose(f);
+	return -1;
+}
+
+bool plan_loaded(void)
+{
+	return num_steps > 0;
+}
+
+/*
+ * Start the next step, the caller applies its filter and interval.
+ * Returns NULL once all steps are done.
+ */
+const struct plan_step *plan_begin(void)
+{
+	char *argv[] = { "/bin/sh", "-c", NULL, NULL };
+	const struct plan_step *st;
+	posix_spawnattr_t attr;
+	extern char **environ;
+
+	if (started && cur < num_steps)
+		cur++;
+	started = true;
+	if (cur >= num_steps)
+		return NULL;
+	st = &steps[cur];
+
+	keep_sinks = sinks_count();
+	if (st->output && sink_add(st->output))
+		fprintf(stderr, "step %s: output '%s' failed\n", st->name,
+			st->output);
+
+	child = 0;
+	if (st->run) {
+		/* a group of its own, so the whole pipeline can be stopped */
+		argv[2] = st->run;
+		posix_spawnattr_init(&attr);
+		posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+		posix_spawnattr_setpgroup(&attr, 0);
+		if (posix_spawn(&child, argv[0], NULL, &attr, argv, environ)) {
+			perror(st->run);
+			child = 0;
+		}
+		posix_spawnattr_destroy(&attr);
+		results[cur].ran = child > 0;
+	}
+	return st;
+}
+
+/* Account a window to the running step, true once the step is over */
+bool plan_account(const struct perf_sample *s)
+{
+	const struct plan_step *st;
+	struct plan_result *r;
+	int status;
+
+	if (!started || cur >= num_steps)
+		return false;
+	st = &steps[cur];
+	r = &results[cur];
+
+	r->windows++;
+	r->elapsed_ns += s->duration_ns + s->suspended_ns;
+	if (!s->suspended_ns)
+		perf_totals_add(&r->totals[s->filter ?
+					   s->filter - filters + 1 : 0], s);
+
+	if (child > 0 && waitpid(child, &status, WNOHANG) == child) {
+		r->status = status;
+		child = 0;
+		if (!st->duration_ms)
+			return true;
+	}
+
+	/* half a window early, or jitter would add one more */
+	return st->duration_ms &&
+	       r->elapsed_ns + s->duration_ns / 2 >= st->duration_ms * 1000000ull;
+}
+
+/* Stop what is left of the step's command and its output */
+void plan_end(void)
+{
+	struct timespec ts = { .tv_nsec = 50000000 };
+	struct plan_result *r;
+	unsigned int waited = 0;
+	int status = 0;
+
+	if (!started || cur >= num_steps)
+		return;
+	r = &results[cur];
+
+	if (child > 0) {
+		kill(-child, SIGTERM);
+		r->killed = true;
+		while (waitpid(child, &status, WNOHANG) == 0) {
+			if (waited >= PLAN_KILL_MS) {
+				kill(-child, SIGKILL);
+				waitpid(child, &status, 0);
+				break;
+			}
+			nanosleep(&ts, NULL);
+			waited += 50;
+		}
+		r->status = status;
+		child = 0;
+	}
+	sinks_trim(keep_sinks);
+}
+
+static void plan_exit_status(FILE *f, const struct plan_result *r)
+{
+	if (!r->ran)
+		fprintf(f, "-");
+	else if (r->killed)
+		fprintf(f, "stopped");
+	else if (WIFEXITED(r->status))
+		fprintf(f, "exit %d", WEXITSTATUS(r->status));
+	else if (WIFSIGNALED(r->status))
+		fprintf(f, "signal %d", WTERMSIG(r->status));
+	else
+		fprintf(f, "?");
+}
+
+void plan_report(FILE *f)
+{
+	const struct perf_totals *t;
+	const struct plan_result *r;
+	unsigned int i, j;
+	double secs;
+	int c;
+
+	if (!num_steps)
+		return;
+
+	fprintf(f, "plan report, %u steps\n", num_steps);
+	for (i = 0; i < num_steps; i++) {
+		r = &results[i];
+		fprintf(f, "step %s: %llu windows, %.1f s, command ",
+			steps[i].name, (unsigned long long)r->windows,
+			r->elapsed_ns / 1e9);
+		plan_exit_status(f, r);
+		fprintf(f, "\n");
+		if (!r->windows)
+			continue;
+
+		fprintf(f, "  %-12s %7s %7s %7s %9s %9s\n", "FILTER",
+			"WINDOWS", "BUSY0%", "BUSY1%", "RD MB/s", "WR MB/s");
+		for (j = 0; j < ARRAY_SIZE(r->totals); j++) {
+			uint64_t rd = 0, wr = 0;
+
+			t = &r->totals[j];
+			if (!t->windows)
+				continue;
+			for (c = 0; c < 2; c++) {
+				rd += t->mmdc[c].read_bytes;
+				wr += t->mmdc[c].write_bytes;
+			}
+			secs = t->duration_ns / 1e9;
+			fprintf(f, "  %-12s %7llu %7.2f %7.2f %9.1f %9.1f\n",
+				j ? filters[j - 1].name : "all",
+				(unsigned long long)t->windows,
+				t->mmdc[0].cycles ? 100.0 *
+				t->mmdc[0].busy_cycles / t->mmdc[0].cycles : 0.0,
+				t->mmdc[1].cycles ? 100.0 *
+				t->mmdc[1].busy_cycles / t->mmdc[1].cycles : 0.0,
+				secs > 0 ? rd / secs / 1e6 : 0.0,
+				secs > 0 ? wr / secs / 1e6 : 0.0);
+		}
+	}
+}
@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Busy-poll sampling for windows of 10 to 100 microseconds, far below
+ * what sleeping allows. The counters run freely and are read back to
+ * back on every tick of a spinning loop; windows are the differences
+ * between consecutive snapshots, so no window is lost to resetting or
+ * freezing the controllers. Snapshots go to a buffer allocated and
+ * locked up front and are only converted and printed once the run is
+ * over.
+ *
+ * The i.MX6 Cortex-A9 has no architected generic timer, the timebase is
+ * CLOCK_MONOTONIC_RAW from the vDSO where the kernel provides it. Its
+ * cost is measured before the run and reported with the read cost.
+ *
+ * With the counters running, the six registers of a snapshot are taken
+ * at slightly different instants. A burst read (one LDM of MADPSR0-5)
+ * keeps that skew small, freezing around the read removes it at the
+ * price of the cycles counted while frozen. poll_skew() measures both
+ * effects by reading MADPSR0 a second time right after a snapshot, in
+ * freeze mode before unfreezing.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "imx6_ddrstat.h"
+
+#define POLL_CALIBRATE	1000
+
+static const char * const poll_read_name[] = {
+	[POLL_READ_SEQ] = "seq",
+	[POLL_READ_BURST] = "burst",
+	[POLL_READ_FREEZE] = "freeze",
+};
+
+struct poll_snap {
+	uint64_t t_ns;		/* timebase right before the register reads */
+	uint32_t read_ns;	/* time the register reads took */
+	uint32_t cnt[2][6];
+};
+
+static inline uint64_t poll_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline void mmdc_read_seq(volatile uint32_t *mmdc, uint32_t *cnt)
+{
+	int i;
+
+	for (i = 0; i < 6; i++)
+		cnt[i] = mmdc[(MMDC_MADPSR0 >> 2) + i];
+}
+
+/* MADPSR0-5 are contiguous, fetch them with a single load multiple */
+static inline void mmdc_read_burst(volatile uint32_t *mmdc, uint32_t *cnt)
+{
+#if defined(__arm__)
+	volatile uint32_t *psr = mmdc + (MMDC_MADPSR0 >> 2);
+
+	__asm__ __volatile__(
+		"ldm	%0, {r4, r5, r6, r8, r10, r12}\n\t"
+		"stm	%1, {r4, r5, r6, r8, r10, r12}"
+		: : "r" (psr), "r" (cnt)
+		: "r4", "r5", "r6", "r8", "r10", "r12", "memory");
+#else
+	mmdc_read_seq(mmdc, cnt);
+#endif
+}
+
+static inline void poll_read(volatile uint32_t *mmdc, bool simulate,
+			     enum poll_read_mode mode, uint32_t *cnt)
+{
+	if (!mmdc)
+		return;
+	if (simulate)
+		sim_update(mmdc);
+
+	switch (mode) {
+	case POLL_READ_SEQ:
+		mmdc_read_seq(mmdc, cnt);
+		break;
+	case POLL_READ_BURST:
+		mmdc_read_burst(mmdc, cnt);
+		break;
+	case POLL_READ_FREEZE:
+		/* the counters run with just DBG_EN set */
+		mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN | MADPCR0_PRF_FRZ;
+		mmdc_read_burst(mmdc, cnt);
+		mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN;
+		break;
+	}
+}
+
+/* median cost of reading the timebase, in nanoseconds */
+static uint64_t poll_timebase_cost(void)
+{
+	uint64_t d[POLL_CALIBRATE], t0, t1;
+	unsigned int i, j;
+
+	for (i = 0; i < POLL_CALIBRATE; i++) {
+		t0 = poll_now();
+		t1 = poll_now();
+		d[i] = t1 - t0;
+	}
+	/* insertion sort, it runs once */
+	for (i = 1; i < POLL_CALIBRATE; i++) {
+		uint64_t v = d[i];
+
+		for (j = i; j && d[j - 1] > v; j--)
+			d[j] = d[j - 1];
+		d[j] = v;
+	}
+	return d[POLL_CALIBRATE / 2];
+}
+
+static int poll_pin(int cpu)
+{
+	cpu_set_t set;
+
+	if (cpu < 0)
+		return 0;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		perror("sched_setaffinity");
+		return -1;
+	}
+	return 0;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void poll_print(FILE *f, const struct poll_snap *snap,
+		       unsigned int count)
+{
+	unsigned int i;
+	int c, r;
+
+	fprintf(f, "offset_ns,duration_ns,read_ns");
+	for (c = 0; c < 2; c++)
+		fprintf(f, ",mmdc%d_cycles,mmdc%d_busy_cycles,mmdc%d_read_accesses,mmdc%d_write_accesses,mmdc%d_read_bytes,mmdc%d_write_bytes",
+			c, c, c, c, c, c);
+	fprintf(f, "\n");
+
+	for (i = 1; i <= count; i++) {
+		const struct poll_snap *a = &snap[i - 1], *b = &snap[i];
+
+		fprintf(f, "%llu,%llu,%u",
+			(unsigned long long)(a->t_ns - snap[0].t_ns),
+			(unsigned long long)(b->t_ns - a->t_ns), b->read_ns);
+		/* unsigned differences survive a counter wrap */
+		for (c = 0; c < 2; c++)
+			for (r = 0; r < 6; r++)
+				fprintf(f, ",%u", b->cnt[c][r] - a->cnt[c][r]);
+		fprintf(f, "\n");
+	}
+}
+
+/*
+ * Take count windows of period_us each from the running counters and
+ * print them as CSV to stdout, optionally pinned to one CPU. The
+ * counters must have been started by the caller.
+ */
+int poll_run(void *mmdc0, void *mmdc1, bool simulate,
+	     enum poll_read_mode mode, unsigned int period_us,
+	     unsigned int count, int cpu)
+{
+	uint64_t period = period_us * 1000ull;
+	uint64_t next, t, t1, tb_cost;
+	uint64_t late_max = 0, read_sum = 0;
+	uint32_t read_min = UINT32_MAX, read_max = 0;
+	unsigned int overruns = 0, i;
+	struct poll_snap *snap;
+	size_t size = (count + 1) * sizeof(*snap);
+
+	if (poll_pin(cpu))
+		return -1;
+
+	snap = malloc(size);
+	if (!snap)
+		return -1;
+	/* fault everything in now, page faults would show up as jitter */
+	memset(snap, 0, size);
+	if (mlockall(MCL_CURRENT | MCL_FUTURE))
+		fprintf(stderr, "poll: mlockall failed, continuing unlocked\n");
+
+	tb_cost = poll_timebase_cost();
+
+	snap[0].t_ns = poll_now();
+	poll_read(mmdc0, simulate, mode, snap[0].cnt[0]);
+	poll_read(mmdc1, simulate, mode, snap[0].cnt[1]);
+	next = snap[0].t_ns + period;
+
+	for (i = 1; i <= count; i++) {
+		while ((t = poll_now()) < next)
+			;
+		poll_read(mmdc0, simulate, mode, snap[i].cnt[0]);
+		poll_read(mmdc1, simulate, mode, snap[i].cnt[1]);
+		t1 = poll_now();
+
+		snap[i].t_ns = t;
+		snap[i].read_ns = t1 - t;
+		if (t - next > late_max)
+			late_max = t - next;
+
+		/* fell a whole window behind, start over from now */
+		next += period;
+		if (t1 >= next) {
+			overruns++;
+			next = t1 + period;
+		}
+	}
+
+	munlockall();
+
+	for (i = 1; i <= count; i++) {
+		read_sum += snap[i].read_ns;
+		if (snap[i].read_ns < read_min)
+			read_min = snap[i].read_ns;
+		if (snap[i].read_ns > read_max)
+			read_max = snap[i].read_ns;
+	}
+
+	poll_print(stdout, snap, count);
+	fflush(stdout);
+
+	fprintf(stderr, "poll: %u windows of %u us, %s reads, timebase %llu ns, read min/avg/max %u/%llu/%u ns, latest %llu ns, %u overruns\n",
+		count, period_us, poll_read_name[mode],
+		(unsigned long long)tb_cost, read_min,
+		(unsigned long long)(count ? read_sum / count : 0), read_max,
+		(unsigned long long)late_max, overruns);
+
+	free(snap);
+	return 0;
+}
+
+/* Parse a --read mode name, -1 if unknown */
+int poll_read_parse(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(poll_read_name); i++)
+		if (strcmp(name, poll_read_name[i]) == 0)
+			return i;
+	return -1;
+}
+
+/*
+ * Take a snapshot and read MADPSR0 again right after it, still frozen
+ * in freeze mode. The cycles it advanced are the span from the first
+ * register to just past the last one; while frozen it should be 0.
+ */
+static uint32_t poll_span(volatile uint32_t *mmdc, bool simulate,
+			  enum poll_read_mode mode, uint32_t *cnt)
+{
+	uint32_t again;
+
+	if (mode != POLL_READ_FREEZE) {
+		poll_read(mmdc, simulate, mode, cnt);
+		if (simulate)
+			sim_update(mmdc);
+		return mmdc[MMDC_MADPSR0 >> 2] - cnt[0];
+	}
+
+	if (simulate)
+		sim_update(mmdc);
+	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN | MADPCR0_PRF_FRZ;
+	mmdc_read_burst(mmdc, cnt);
+	if (simulate)
+		sim_update(mmdc);
+	again = mmdc[MMDC_MADPSR0 >> 2];
+	mmdc[MMDC_MADPCR0 >> 2] = MADPCR0_DBG_EN;
+	return again - cnt[0];
+}
+
+/*
+ * Quantify the inter-register skew of each read mode on MMDC0. With a
+ * window of period_us, the registers of one snapshot then disagree by
+ * up to span / window of the window, which is how far bytes/access
+ * and the other derived metrics can be off. Freezing should show no
+ * span but does not count the time it is frozen.
+ */
+int poll_skew(void *mmdc0, bool simulate, unsigned int period_us,
+	      unsigned int count, int cpu)
+{
+	volatile uint32_t *mmdc = mmdc0;
+	uint32_t cnt[6], *span;
+	uint64_t t0, t1, c0, c1, tb_cost, window = period_us * 1000ull;
+	double hz, ns, cost;
+	unsigned int i;
+	int mode;
+
+	if (poll_pin(cpu))
+		return -1;
+
+	span = malloc(count * sizeof(*span));
+	if (!span)
+		return -1;
+
+	tb_cost = poll_timebase_cost();
+
+	/* DDR clock from the cycle counter, for converting spans to ns */
+	if (simulate)
+		sim_update(mmdc);
+	c0 = mmdc[MMDC_MADPSR0 >> 2];
+	t0 = poll_now();
+	while (poll_now() - t0 < 10000000)
+		;
+	if (simulate)
+		sim_update(mmdc);
+	c1 = mmdc[MMDC_MADPSR0 >> 2];
+	t1 = poll_now();
+	hz = (uint32_t)(c1 - c0) * 1e9 / (t1 - t0);
+
+	printf("DDR clock %.1f MHz, timebase %llu ns, %u reads per mode, window %u us\n",
+	       hz / 1e6, (unsigned long long)tb_cost, count, period_us);
+	printf("%-8s %26s %12s %10s %14s %12s\n", "MODE",
+	       "SPAN CYCLES MIN/MED/MAX", "SPAN NS MAX", "READ NS",
+	       "SKEW %", "UNCOUNTED");
+
+	for (mode = 0; mode < (int)ARRAY_SIZE(poll_read_name); mode++) {
+		t0 = poll_now();
+		for (i = 0; i < count; i++)
+			span[i] = poll_span(mmdc, simulate, mode, cnt);
+		t1 = poll_now();
+		qsort(span, count, sizeof(*span), cmp_u32);
+
+		/* per snapshot, including the extra MADPSR0 read */
+		cost = (double)(t1 - t0) / count;
+		ns = hz > 0 ? span[count - 1] * 1e9 / hz : 0.0;
+		printf("%-8s %10u/%7u/%7u %12.0f %10.0f %13.3f%% %11.3f%%\n",
+		       poll_read_name[mode], span[0], span[count / 2],
+		       span[count - 1], ns, cost,
+		       100.0 * ns / window,
+		       mode == POLL_READ_FREEZE ? 100.0 * cost / window : 0.0);
+	}
+
+	free(span);
+	return 0;
+}
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Per-process attribution of ARM DDR traffic. The MMDC only knows AXI
+ * masters, so the bytes of windows filtered to arm-s0 or arm-s1 are
+ * split across processes in proportion to a per-thread perf counter
+ * read over the same window: last level cache read misses where the PMU
+ * offers them, else cache misses, else (without a PMU) CPU time. Every
+ * thread gets its own counter; /proc is rescanned after each window to
+ * pick up new threads, and exited ones are read a last time and closed.
+ *
+ * --procs[=N]   report the top N processes on exit (default 10)
+ *
+ * This is an estimate: cache misses that hit in the L2, prefetches and
+ * write-backs are not told apart, and kernel work is charged to the
+ * thread it ran on.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "imx6_ddrstat.h"
+
+#define PROCS_MAX_TASKS	4096
+
+struct procs_task {
+	pid_t tid;
+	unsigned int proc;	/* index into procs[] */
+	int fd;
+	uint64_t last;
+	uint64_t delta;
+	bool seen;
+};
+
+struct procs_proc {
+	pid_t pid;
+	char comm[17];
+	double bytes[2];	/* attributed per ARM port */
+	uint64_t events;
+};
+
+static const struct {
+	const char *name;
+	uint32_t type;
+	uint64_t config;
+} weights[] = {
+	{ "last level cache read misses", PERF_TYPE_HW_CACHE,
+	  PERF_COUNT_HW_CACHE_LL |
+	  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ "cache misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ "CPU time", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+};
+
+static bool enabled;
+static unsigned int top = 10;
+static struct perf_event_attr attr;
+static const char *weight;
+
+static struct procs_task *tasks;
+static unsigned int num_tasks, max_tasks;
+static struct procs_proc *procs;
+static unsigned int num_procs;
+static uint64_t port_ns[2];
+static double unattributed;	/* bytes of windows without any events */
+
+static int procs_open_counter(pid_t tid)
+{
+	return syscall(SYS_perf_event_open, &attr, tid, -1, -1,
+		       PERF_FLAG_FD_CLOEXEC);
+}
+
+/* Counter value scaled up for the time it was multiplexed out */
+static uint64_t procs_read(int fd)
+{
+	uint64_t v[3];
+
+	if (read(fd, v, sizeof(v)) != sizeof(v) || !v[2])
+		return 0;
+	return v[2] < v[1] ? (double)v[0] * v[1] / v[2] : v[0];
+}
+
+/* Index of the process in procs[], added on first sight, -1 on error */
+static int procs_get(pid_t pid)
+{
+	struct procs_proc *p;
+	char path[64];
+	FILE *f;
+	unsigned int i;
+
+	for (i = 0; i < num_procs; i++)
+		if (procs[i].pid == pid)
+			return i;
+
+	p = realloc(procs, (num_procs + 1) * sizeof(*procs));
+	if (!p)
+		return -1;
+	procs = p;
+	p = &procs[num_procs++];
+	memset(p, 0, sizeof(*p));
+	p->pid = pid;
+
+	snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+	f = fopen(path, "r");
+	if (!f || !fgets(p->comm, sizeof(p->comm), f))
+		strcpy(p->comm, "?");
+	p->comm[strcspn(p->comm, "\n")] = '\0';
+	if (f)
+		fclose(f);
+	return num_procs - 1;
+}
+
+static struct procs_task *procs_task_find(pid_t tid)
+{
+	unsigned int i;
+
+	for (i = 0; i < num_tasks; i++)
+		if (tasks[i].tid == tid)
+			return &tasks[i];
+	return NULL;
+}
+
+static void procs_task_add(pid_t pid, pid_t tid)
+{
+	struct procs_task *t;
+	int fd, proc;
+
+	if (num_tasks == max_tasks)
+		return;
+	fd = procs_open_counter(tid);
+	if (fd < 0)
+		return;
+
+	proc = procs_get(pid);
+	if (proc < 0) {
+		close(fd);
+		return;
+	}
+	t = &tasks[num_tasks++];
+	t->proc = proc;
+	t->tid = tid;
+	t->fd = fd;
+	t->last = procs_read(fd);
+	t->seen = true;
+}
+
+/* Open counters for threads that appeared since the last scan */
+static void procs_scan(void)
+{
+	struct dirent *pe, *te;
+	struct procs_task *t;
+	DIR *proc, *task;
+	char path[64];
+	pid_t pid, tid;
+
+	proc = opendir("/proc");
+	if (!proc)
+		return;
+
+	while ((pe = readdir(proc))) {
+		pid = strtol(pe->d_name, NULL, 10);
+		if (pid <= 0)
+			continue;
+		snprintf(path, sizeof(path), "/proc/%d/task", pid);
+		task = opendir(path);
+		if (!task)
+			continue;
+		while ((te = readdir(task))) {
+			tid = strtol(te->d_name, NULL, 10);
+			if (tid <= 0)
+				continue;
+			t = procs_task_find(tid);
+			if (t)
+				t->seen = true;
+			else
+				procs_task_add(pid, tid);
+		}
+		closedir(task);
+	}
+	closedir(proc);
+}
+
+int procs_init(const char *spec)
+{
+	struct rlimit rl;
+	unsigned int i;
+	char *end;
+	int fd;
+
+	if (spec) {
+		top = strtoul(spec, &end, 0);
+		if (*end || !top) {
+			fprintf(stderr, "invalid process count '%s'\n", spec);
+			return -1;
+		}
+	}
+
+	attr.size = sizeof(attr);
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+			   PERF_FORMAT_TOTAL_TIME_RUNNING;
+	for (i = 0; i < ARRAY_SIZE(weights); i++) {
+		attr.type = weights[i].type;
+		attr.config = weights[i].config;
+		fd = procs_open_counter(0);
+		if (fd >= 0) {
+			close(fd);
+			weight = weights[i].name;
+			break;
+		}
+	}
+	if (!weight) {
+		perror("perf_event_open");
+		return -1;
+	}
+
+	/* one descriptor per thread */
+	max_tasks = PROCS_MAX_TASKS;
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+		getrlimit(RLIMIT_NOFILE, &rl);
+		if (rl.rlim_cur < max_tasks + 64)
+			max_tasks = rl.rlim_cur > 128 ? rl.rlim_cur - 64 : 64;
+	}
+	tasks = calloc(max_tasks, sizeof(*tasks));
+	if (!tasks)
+		return -1;
+
+	/* baselines for the first window */
+	procs_scan();
+	enabled = true;
+	return 0;
+}
+
+bool procs_enabled(void)
+{
+	return enabled;
+}
+
+/* Only windows on the ARM ports are attributed */
+int procs_sweep_list(char *buf, size_t size)
+{
+	return snprintf(buf, size, "arm-s0,arm-s1") < (int)size ? 0 : -1;
+}
+
+void procs_account(const struct perf_sample *s)
+{
+	struct procs_task *t;
+	uint64_t now, total = 0;
+	double bytes = 0.0;
+	unsigned int i, n;
+	int port = -1;
+	int c;
+
+	if (!enabled)
+		return;
+
+	for (i = 0; i < num_tasks; i++) {
+		t = &tasks[i];
+		now = procs_read(t->fd);
+		t->delta = now > t->last ? now - t->last : 0;
+		t->last = now;
+		total += t->delta;
+	}
+
+	if (s->filter && strncmp(s->filter->name, "arm-s", 5) == 0)
+		port = s->filter->name[5] - '0';
+	if (port >= 0 && !s->suspended_ns) {
+		for (c = 0; c < 2; c++)
+			bytes += (double)s->mmdc[c].read_bytes +
+				 s->mmdc[c].write_bytes;
+		port_ns[port] += s->duration_ns;
+		if (!total)
+			unattributed += bytes;
+		for (i = 0; total && i < num_tasks; i++) {
+			t = &tasks[i];
+			procs[t->proc].bytes[port] += bytes * t->delta / total;
+			procs[t->proc].events += t->delta;
+		}
+	}
+
+	/* exited threads had their last count read above */
+	for (i = 0; i < num_tasks; i++)
+		tasks[i].seen = false;
+	procs_scan();
+	for (i = n = 0; i < num_tasks; i++) {
+		if (tasks[i].seen)
+			tasks[n++] = tasks[i];
+		else
+			close(tasks[i].fd);
+	}
+	num_tasks = n;
+}
+
+struct procs_row {
+	const struct procs_proc *proc;
+	double mbps;
+};
+
+static int procs_cmp(const void *a, const void *b)
+{
+	const struct procs_row *ra = a, *rb = b;
+
+	return ra->mbps < rb->mbps ? 1 : ra->mbps > rb->mbps ? -1 : 0;
+}
+
+/* bytes per port over the time that port was measured */
+static double procs_mbps(const double *bytes)
+{
+	double mbps = 0.0;
+	int port;
+
+	for (port = 0; port < 2; port++)
+		if (port_ns[port])
+			mbps += bytes[port] / (port_ns[port] / 1e9) / 1e6;
+	return mbps;
+}
+
+void procs_report(FILE *f)
+{
+	struct procs_row *rows;
+	double total = 0.0;
+	unsigned int i, n = 0;
+
+	if (!enabled)
+		return;
+	if (!port_ns[0] && !port_ns[1]) {
+		fprintf(f, "processes: no arm-s0 or arm-s1 windows\n");
+		return;
+	}
+
+	rows = calloc(num_procs, sizeof(*rows));
+	if (!rows && num_procs)
+		return;
+	for (i = 0; i < num_procs; i++) {
+		if (!procs[i].events)
+			continue;
+		rows[n].proc = &procs[i];
+		rows[n].mbps = procs_mbps(procs[i].bytes);
+		total += rows[n++].mbps;
+	}
+	qsort(rows, n, sizeof(*rows), procs_cmp);
+
+	fprintf(f, "ARM DDR traffic by process, weighted by %s\n", weight);
+	fprintf(f, "%7s %-16s %9s %7s\n", "PID", "COMMAND", "MB/s", "SHARE%");
+	for (i = 0; i < n && i < top; i++)
+		fprintf(f, "%7d %-16s %9.2f %7.1f\n", rows[i].proc->pid,
+			rows[i].proc->comm, rows[i].mbps,
+			total > 0.0 ? 100.0 * rows[i].mbps / total : 0.0);
+	if (unattributed > 0.0)
+		fprintf(f, "%.1f MB in windows without counted events\n",
+			unattributed / 1e6);
+	free(rows);
+}
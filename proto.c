@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "ddrstat_proto.h"
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+	put_le16(p, v);
+	put_le16(p + 2, v >> 16);
+}
+
+static void put_le64(uint8_t *p, uint64_t v)
+{
+	put_le32(p, v);
+	put_le32(p + 4, v >> 32);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+	return get_le16(p) | (uint32_t)get_le16(p + 2) << 16;
+}
+
+static uint64_t get_le64(const uint8_t *p)
+{
+	return get_le32(p) | (uint64_t)get_le32(p + 4) << 32;
+}
+
+size_t ddrstat_put_header(uint8_t *buf, const struct ddrstat_batch *b)
+{
+	put_le32(buf, DDRSTAT_MAGIC);
+	put_le16(buf + 4, DDRSTAT_VERSION);
+	put_le16(buf + 6, b->count);
+	put_le16(buf + 8, DDRSTAT_HEADER_SIZE);
+	put_le16(buf + 10, DDRSTAT_SAMPLE_SIZE);
+	put_le32(buf + 12, b->seq);
+	put_le32(buf + 16, b->dropped);
+	memset(buf + 20, 0, DDRSTAT_DEVICE_LEN);
+	memcpy(buf + 20, b->device, strnlen(b->device, DDRSTAT_DEVICE_LEN));
+
+	return DDRSTAT_HEADER_SIZE;
+}
+
+int ddrstat_get_header(const uint8_t *buf, size_t len,
+		       struct ddrstat_batch *b)
+{
+	if (len < DDRSTAT_HEADER_SIZE || get_le32(buf) != DDRSTAT_MAGIC)
+		return -1;
+
+	b->version = get_le16(buf + 4);
+	b->count = get_le16(buf + 6);
+	b->header_size = get_le16(buf + 8);
+	b->sample_size = get_le16(buf + 10);
+	b->seq = get_le32(buf + 12);
+	b->dropped = get_le32(buf + 16);
+	memcpy(b->device, buf + 20, DDRSTAT_DEVICE_LEN);
+	b->device[DDRSTAT_DEVICE_LEN] = '\0';
+
+	if (b->header_size < DDRSTAT_HEADER_SIZE ||
+	    b->sample_size < DDRSTAT_SAMPLE_SIZE_V1)
+		return -1;
+
+	/*
+	 * Receivers buffer whole batches, a peer may not make them huge.
+	 * Bytes are what counts: version 1 batches hold up to 16 of the
+	 * smaller samples.
+	 */
+	if (b->header_size + (size_t)b->count * b->sample_size >
+	    DDRSTAT_MAX_FRAME)
+		return -1;
+
+	return 0;
+}
+
+size_t ddrstat_put_sample(uint8_t *buf, const struct perf_sample *s)
+{
+	const uint32_t *cnt;
+	uint32_t flags = 0;
+	int c, i;
+
+	if (s->filter)
+		flags |= DDRSTAT_FLAG_FILTERED;
+	if (s->has_corr)
+		flags |= DDRSTAT_FLAG_CORR;
+	if (s->sweep)
+		flags |= DDRSTAT_FLAG_SWEEP;
+	if (s->suspended_ns)
+		flags |= DDRSTAT_FLAG_SUSPENDED;
+
+	put_le64(buf, s->duration_ns);
+	put_le16(buf + 8, s->filter ? s->filter->axi_id : 0);
+	put_le16(buf + 10, s->filter ? s->filter->axi_id_mask : 0);
+	put_le32(buf + 12, flags);
+	for (c = 0; c < 2; c++) {
+		cnt = (const uint32_t *)&s->mmdc[c];
+		for (i = 0; i < 6; i++)
+			put_le32(buf + 16 + (c * 6 + i) * 4, cnt[i]);
+	}
+
+	put_le64(buf + 64, s->start_raw_ns);
+	put_le64(buf + 72, s->end_raw_ns);
+	put_le64(buf + 80, s->start_boot_ns);
+	put_le64(buf + 88, s->end_boot_ns);
+	put_le64(buf + 96, s->has_corr ? s->corr.realtime_ns : 0);
+	put_le64(buf + 104, s->has_corr ? s->corr.raw_ns : 0);
+	put_le64(buf + 112, s->has_corr ? s->corr.boot_ns : 0);
+	put_le32(buf + 120, s->has_corr ? s->corr.uncertainty_ns : 0);
+	put_le32(buf + 124, 0);
+
+	return DDRSTAT_SAMPLE_SIZE;
+}
+
+/* size is the sample_size from the batch header */
+void ddrstat_get_sample(const uint8_t *buf, size_t size,
+			struct perf_sample *s)
+{
+	uint32_t flags = get_le32(buf + 12);
+	uint32_t *cnt;
+	int c, i;
+
+	memset(s, 0, sizeof(*s));
+	s->duration_ns = get_le64(buf);
+	if (flags & DDRSTAT_FLAG_FILTERED)
+		s->filter = axi_filter_lookup(get_le16(buf + 8),
+					      get_le16(buf + 10));
+	s->sweep = flags & DDRSTAT_FLAG_SWEEP;
+	for (c = 0; c < 2; c++) {
+		cnt = (uint32_t *)&s->mmdc[c];
+		for (i = 0; i < 6; i++)
+			cnt[i] = get_le32(buf + 16 + (c * 6 + i) * 4);
+	}
+
+	if (size < DDRSTAT_SAMPLE_SIZE)
+		return;
+
+	s->start_raw_ns = get_le64(buf + 64);
+	s->end_raw_ns = get_le64(buf + 72);
+	s->start_boot_ns = get_le64(buf + 80);
+	s->end_boot_ns = get_le64(buf + 88);
+	if (flags & DDRSTAT_FLAG_SUSPENDED)
+		s->suspended_ns = (s->end_boot_ns - s->start_boot_ns) -
+				  (s->end_raw_ns - s->start_raw_ns);
+	s->has_corr = flags & DDRSTAT_FLAG_CORR;
+	if (s->has_corr) {
+		s->corr.realtime_ns = get_le64(buf + 96);
+		s->corr.raw_ns = get_le64(buf + 104);
+		s->corr.boot_ns = get_le64(buf + 112);
+		s->corr.uncertainty_ns = get_le32(buf + 120);
+	}
+}
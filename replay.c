@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Replay of binary recordings (--sink=binary:FILE) in place of the
+ * MMDC, so the sinks, the dashboard, alerts and the reports run over a
+ * capture exactly as they would live.
+ *
+ * --replay=FILE[,speed=FACTOR]
+ *
+ *   FILE     recording, '-' for stdin
+ *   speed    playback speed relative to the recording (default 1),
+ *            0 replays as fast as possible
+ *
+ * Windows are paced by the distance between their end timestamps, or by
+ * their duration for version 1 recordings which have no timestamps.
+ * Sinks block instead of dropping windows while replaying, unless given
+ * another policy.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ddrstat_proto.h"
+
+static FILE *file;
+static double speed = 1.0;
+
+/* the batch being replayed */
+static struct ddrstat_batch batch;
+/* room for batches from senders with larger samples */
+static uint8_t buf[16 * DDRSTAT_MAX_FRAME];
+static uint8_t *next;
+static unsigned int left;
+
+static uint64_t last_end_ns;
+static uint64_t replayed;
+static struct timespec started;
+
+static int replay_option(const char *opt)
+{
+	char *end;
+
+	if (strncmp(opt, "speed=", 6) != 0)
+		return -1;
+	speed = strtod(opt + 6, &end);
+	if (*end || speed < 0.0)
+		return -1;
+	return 0;
+}
+
+/* Read the next batch header and its samples, 1 at the end of the file */
+static int replay_read_batch(void)
+{
+	uint8_t hdr[DDRSTAT_HEADER_SIZE];
+	size_t len, extra;
+
+	if (fread(hdr, sizeof(hdr), 1, file) != 1)
+		return feof(file) ? 1 : -1;
+
+	if (ddrstat_get_header(hdr, sizeof(hdr), &batch)) {
+		fprintf(stderr, "not a ddrstat recording\n");
+		return -1;
+	}
+
+	/* header fields appended by newer versions are skipped */
+	extra = batch.header_size - sizeof(hdr);
+	len = extra + (size_t)batch.count * batch.sample_size;
+	if (len > sizeof(buf)) {
+		fprintf(stderr, "recording batch too large\n");
+		return -1;
+	}
+	if (len && fread(buf, len, 1, file) != 1) {
+		fprintf(stderr, "truncated recording\n");
+		return -1;
+	}
+
+	next = buf + extra;
+	left = batch.count;
+	return 0;
+}
+
+int replay_open(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *opts, *opt, *saveptr;
+
+	if (!copy)
+		return -1;
+
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (replay_option(opt)) {
+			fprintf(stderr, "invalid replay option '%s'\n", opt);
+			goto err;
+		}
+	}
+
+	file = strcmp(copy, "-") == 0 ? stdin : fopen(copy, "r");
+	if (!file) {
+		perror(copy);
+		goto err;
+	}
+
+	/* the first header names the recorded device */
+	if (replay_read_batch())
+		goto err;
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	free(copy);
+	return 0;
+err:
+	free(copy);
+	return -1;
+}
+
+const char *replay_device(void)
+{
+	return batch.device;
+}
+
+/*
+ * Return the next recorded window and how long to wait before handing it
+ * out, 1 at the end of the recording.
+ */
+int replay_next(struct perf_sample *s, unsigned int *delay_ms)
+{
+	uint64_t delay_ns;
+	int err;
+
+	while (!left) {
+		err = replay_read_batch();
+		if (err)
+			return err;
+	}
+
+	ddrstat_get_sample(next, batch.sample_size, s);
+	next += batch.sample_size;
+	left--;
+
+	if (s->end_raw_ns && last_end_ns && s->end_raw_ns > last_end_ns)
+		delay_ns = s->end_raw_ns - last_end_ns;
+	else
+		delay_ns = s->duration_ns;
+	last_end_ns = s->end_raw_ns;
+
+	*delay_ms = speed > 0.0 ? delay_ns / speed / 1e6 : 0;
+	replayed++;
+	return 0;
+}
+
+/* Close the recording and report the replay rate */
+void replay_close(void)
+{
+	struct timespec now;
+	double secs;
+
+	if (!file)
+		return;
+	if (file != stdin)
+		fclose(file);
+	file = NULL;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	secs = (now.tv_sec - started.tv_sec) +
+	       (now.tv_nsec - started.tv_nsec) / 1e9;
+	fprintf(stderr, "replayed %llu windows in %.3f s (%.0f windows/s)\n",
+		(unsigned long long)replayed, secs,
+		secs > 0.0 ? replayed / secs : 0.0);
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compact framing for serial consoles, see ddrstat_serial.h. Used by
+ * the serial sink and by the ddrstat_serial decoder on the host.
+ */
+
+#include <string.h>
+
+#include "ddrstat_proto.h"
+#include "ddrstat_serial.h"
+
+static const char b64[] =
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* CRC-16/CCITT-FALSE */
+static uint16_t crc16(const uint8_t *p, size_t len)
+{
+	uint16_t crc = 0xffff;
+	int i;
+
+	while (len--) {
+		crc ^= *p++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static uint8_t *put_varint(uint8_t *p, uint64_t v)
+{
+	while (v >= 0x80) {
+		*p++ = v | 0x80;
+		v >>= 7;
+	}
+	*p++ = v;
+	return p;
+}
+
+/* NULL if the varint runs past end or is longer than 64 bits */
+static const uint8_t *get_varint(const uint8_t *p, const uint8_t *end,
+				 uint64_t *v)
+{
+	unsigned int shift = 0;
+
+	*v = 0;
+	while (p < end && shift < 64) {
+		*v |= (uint64_t)(*p & 0x7f) << shift;
+		if (!(*p++ & 0x80))
+			return p;
+		shift += 7;
+	}
+	return NULL;
+}
+
+static size_t base64_encode(char *out, const uint8_t *in, size_t len)
+{
+	char *o = out;
+	uint32_t v;
+	size_t i;
+
+	for (i = 0; i < len; i += 3) {
+		v = in[i] << 16;
+		if (i + 1 < len)
+			v |= in[i + 1] << 8;
+		if (i + 2 < len)
+			v |= in[i + 2];
+		*o++ = b64[v >> 18];
+		*o++ = b64[(v >> 12) & 0x3f];
+		*o++ = i + 1 < len ? b64[(v >> 6) & 0x3f] : '=';
+		*o++ = i + 2 < len ? b64[v & 0x3f] : '=';
+	}
+	return o - out;
+}
+
+/* Decode up to the first non-base64 character, -1 on malformed input */
+static int base64_decode(uint8_t *out, size_t size, const char *in)
+{
+	unsigned int bits = 0, n = 0;
+	uint32_t v = 0;
+	const char *c;
+
+	for (; *in && *in != '='; in++) {
+		c = strchr(b64, *in);
+		if (!c)
+			break;
+		v = v << 6 | (c - b64);
+		bits += 6;
+		if (bits >= 8) {
+			bits -= 8;
+			if (n == size)
+				return -1;
+			out[n++] = v >> bits;
+		}
+	}
+	return bits >= 6 ? -1 : (int)n;
+}
+
+size_t serial_encode(char *line, uint32_t seq, const struct perf_sample *s)
+{
+	uint8_t frame[DDRSTAT_SERIAL_FRAME];
+	uint8_t *p = frame;
+	const uint32_t *cnt;
+	uint16_t crc;
+	uint8_t flags = 0;
+	size_t len;
+	int c, i;
+
+	if (s->filter)
+		flags |= DDRSTAT_FLAG_FILTERED;
+	if (s->has_corr)
+		flags |= DDRSTAT_FLAG_CORR;
+	if (s->sweep)
+		flags |= DDRSTAT_FLAG_SWEEP;
+	if (s->suspended_ns)
+		flags |= DDRSTAT_FLAG_SUSPENDED;
+
+	*p++ = DDRSTAT_SERIAL_VERSION;
+	*p++ = flags;
+	p = put_varint(p, seq);
+	p = put_varint(p, s->duration_ns / 1000);
+	p = put_varint(p, s->end_raw_ns / 1000);
+	p = put_varint(p, (s->end_boot_ns - s->end_raw_ns) / 1000);
+	if (s->suspended_ns)
+		p = put_varint(p, s->suspended_ns / 1000);
+	if (s->filter) {
+		p = put_varint(p, s->filter->axi_id);
+		p = put_varint(p, s->filter->axi_id_mask);
+	}
+	for (c = 0; c < 2; c++) {
+		cnt = (const uint32_t *)&s->mmdc[c];
+		for (i = 0; i < 6; i++)
+			p = put_varint(p, cnt[i]);
+	}
+	if (s->has_corr) {
+		p = put_varint(p, s->corr.realtime_ns);
+		p = put_varint(p, s->corr.raw_ns);
+		p = put_varint(p, s->corr.boot_ns);
+		p = put_varint(p, s->corr.uncertainty_ns);
+	}
+	crc = crc16(frame, p - frame);
+	*p++ = crc >> 8;
+	*p++ = crc;
+
+	memcpy(line, DDRSTAT_SERIAL_MARKER, 2);
+	len = 2 + base64_encode(line + 2, frame, p - frame);
+	line[len++] = '\n';
+	line[len] = '\0';
+	return len;
+}
+
+/* Decode the frame following the first marker in line, -1 if corrupt */
+int serial_decode(const char *line, uint32_t *seq, struct perf_sample *s)
+{
+	uint8_t frame[DDRSTAT_SERIAL_FRAME];
+	const uint8_t *p = frame, *end;
+	const char *start = strstr(line, DDRSTAT_SERIAL_MARKER);
+	uint64_t v[23];
+	unsigned int n = 0, want;
+	uint32_t *cnt;
+	uint8_t flags;
+	int len, c, i;
+
+	if (!start)
+		return -1;
+	len = base64_decode(frame, sizeof(frame), start + 2);
+	if (len < 4 || crc16(frame, len - 2) !=
+	    (frame[len - 2] << 8 | frame[len - 1]))
+		return -1;
+	end = frame + len - 2;
+	if (*p++ != DDRSTAT_SERIAL_VERSION)
+		return -1;
+	flags = *p++;
+
+	want = 4 + 12;
+	if (flags & DDRSTAT_FLAG_SUSPENDED)
+		want++;
+	if (flags & DDRSTAT_FLAG_FILTERED)
+		want += 2;
+	if (flags & DDRSTAT_FLAG_CORR)
+		want += 4;
+	while (n < want) {
+		p = get_varint(p, end, &v[n++]);
+		if (!p)
+			return -1;
+	}
+	if (p != end)
+		return -1;
+
+	memset(s, 0, sizeof(*s));
+	n = 0;
+	*seq = v[n++];
+	s->duration_ns = v[n++] * 1000;
+	s->end_raw_ns = v[n++] * 1000;
+	s->end_boot_ns = s->end_raw_ns + v[n++] * 1000;
+	if (flags & DDRSTAT_FLAG_SUSPENDED)
+		s->suspended_ns = v[n++] * 1000;
+	s->start_raw_ns = s->end_raw_ns - s->duration_ns;
+	s->start_boot_ns = s->end_boot_ns - s->duration_ns - s->suspended_ns;
+	if (flags & DDRSTAT_FLAG_FILTERED) {
+		s->filter = axi_filter_lookup(v[n], v[n + 1]);
+		n += 2;
+	}
+	s->sweep = flags & DDRSTAT_FLAG_SWEEP;
+	for (c = 0; c < 2; c++) {
+		cnt = (uint32_t *)&s->mmdc[c];
+		for (i = 0; i < 6; i++)
+			cnt[i] = v[n++];
+	}
+	s->has_corr = flags & DDRSTAT_FLAG_CORR;
+	if (s->has_corr) {
+		s->corr.realtime_ns = v[n++];
+		s->corr.raw_ns = v[n++];
+		s->corr.boot_ns = v[n++];
+		s->corr.uncertainty_ns = v[n++];
+	}
+	return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Shared memory ring between ddrstat_helper and its front ends, see
+ * ddrstat_shm.h for the layout.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "ddrstat_shm.h"
+
+static long futex(uint32_t *uaddr, int op, uint32_t val,
+		  const struct timespec *timeout)
+{
+	return syscall(SYS_futex, uaddr, op, val, timeout, NULL, 0);
+}
+
+/*
+ * Create the segment for the helper. It is handed to uid, which the
+ * helper is about to become, so it can still remove it on exit, and
+ * shared with the front ends in gid.
+ */
+struct ddrstat_shm *ddrstat_shm_create(const char *name, uid_t uid,
+				       gid_t gid)
+{
+	struct ddrstat_shm *shm;
+	uint32_t pid;
+	int fd;
+
+	/* a helper that crashed leaves its segment behind, a running one
+	 * keeps it */
+	shm = ddrstat_shm_open(name);
+	if (shm) {
+		pid = __atomic_load_n(&shm->helper_pid, __ATOMIC_ACQUIRE);
+		ddrstat_shm_close(shm);
+		if (pid && (kill(pid, 0) == 0 || errno == EPERM)) {
+			errno = EEXIST;
+			return NULL;
+		}
+	}
+	shm_unlink(name);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0660);
+	if (fd < 0)
+		return NULL;
+
+	if (fchown(fd, uid, gid) || fchmod(fd, 0660) ||
+	    ftruncate(fd, sizeof(*shm))) {
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED,
+		   fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		shm_unlink(name);
+		return NULL;
+	}
+
+	shm->version = DDRSTAT_SHM_VERSION;
+	shm->helper_pid = getpid();
+	shm->req_filter = -1;
+	__atomic_store_n(&shm->magic, DDRSTAT_SHM_MAGIC, __ATOMIC_RELEASE);
+	return shm;
+}
+
+struct ddrstat_shm *ddrstat_shm_open(const char *name)
+{
+	struct ddrstat_shm *shm;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) || st.st_size < (off_t)sizeof(*shm)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	shm = mmap(NULL, sizeof(*shm), PROT_READ | PROT_WRITE, MAP_SHARED,
+		   fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED)
+		return NULL;
+
+	if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) !=
+	    DDRSTAT_SHM_MAGIC || shm->version != DDRSTAT_SHM_VERSION) {
+		munmap(shm, sizeof(*shm));
+		errno = EPROTO;
+		return NULL;
+	}
+	return shm;
+}
+
+void ddrstat_shm_close(struct ddrstat_shm *shm)
+{
+	munmap(shm, sizeof(*shm));
+}
+
+void ddrstat_shm_publish(struct ddrstat_shm *shm, const struct perf_sample *s)
+{
+	uint32_t n = shm->published;
+
+	/* readers must see the previous count before the slot changes */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	ddrstat_put_sample(shm->slot[n % DDRSTAT_SHM_SLOTS], s);
+	__atomic_store_n(&shm->published, n + 1, __ATOMIC_RELEASE);
+	futex(&shm->published, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+/*
+ * Fetch the window at *next, waiting up to timeout_ms for it. Returns 0
+ * with the sample, 1 on timeout. Windows overwritten before they were
+ * read are skipped and added to *lost.
+ */
+int ddrstat_shm_fetch(struct ddrstat_shm *shm, uint32_t *next,
+		      struct perf_sample *s, unsigned int timeout_ms,
+		      uint32_t *lost)
+{
+	struct timespec ts = {
+		.tv_sec = timeout_ms / 1000,
+		.tv_nsec = (timeout_ms % 1000) * 1000000,
+	};
+	uint8_t buf[DDRSTAT_SAMPLE_SIZE];
+	uint32_t pub;
+
+	for (;;) {
+		pub = __atomic_load_n(&shm->published, __ATOMIC_ACQUIRE);
+		if (pub == *next) {
+			if (futex(&shm->published, FUTEX_WAIT, pub, &ts) &&
+			    errno == ETIMEDOUT)
+				return 1;
+			continue;
+		}
+
+		if (pub - *next > DDRSTAT_SHM_SLOTS) {
+			*lost += pub - *next - DDRSTAT_SHM_SLOTS;
+			*next = pub - DDRSTAT_SHM_SLOTS;
+		}
+		memcpy(buf, shm->slot[*next % DDRSTAT_SHM_SLOTS], sizeof(buf));
+
+		/* the writer may have lapped us while copying */
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		pub = __atomic_load_n(&shm->published, __ATOMIC_RELAXED);
+		if (pub - *next >= DDRSTAT_SHM_SLOTS) {
+			(*lost)++;
+			(*next)++;
+			continue;
+		}
+
+		ddrstat_get_sample(buf, sizeof(buf), s);
+		(*next)++;
+		return 0;
+	}
+}
+
+void ddrstat_shm_request(struct ddrstat_shm *shm, int filter,
+			 unsigned int interval_ms)
+{
+	shm->req_filter = filter;
+	shm->req_interval_ms = interval_ms;
+	__atomic_add_fetch(&shm->req_seq, 1, __ATOMIC_RELEASE);
+}
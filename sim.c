@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Simulated MMDC for running on a host without /dev/mem access. The
+ * register pages live in ordinary memory and the profiling counters are
+ * advanced from a synthetic per-master traffic profile whenever the
+ * sampler is about to read them, honouring the AXI filter programmed
+ * into MADPCR1 and the PRF_FRZ bit, so sweeps behave like on hardware.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "imx6_ddrstat.h"
+
+#define SIM_DDR_HZ		528000000.0
+/* 64-bit bus, DDR: 16 bytes per clock at best, less for page misses */
+#define SIM_BYTES_PER_BUSY	10.0
+
+struct sim_master {
+	const char *name;
+	double read_bps;
+	double write_bps;
+	unsigned int read_size;
+	unsigned int write_size;
+	double period;		/* seconds, load swings with this period */
+};
+
+static const struct sim_master sim_masters[] = {
+	{ "arm-s0",    180e6,  70e6, 32, 32, 17.0 },
+	{ "arm-s1",     60e6,  25e6, 32, 32, 23.0 },
+	{ "ipu1-0",    475e6,     0, 64,  0,  0.0 },
+	{ "ipu1-1",     90e6,  90e6, 64, 64, 31.0 },
+	{ "gpu3d-a",   220e6, 110e6, 64, 32, 11.0 },
+	{ "gpu3d-b",    60e6,  30e6, 64, 32, 13.0 },
+	{ "vpu-prime", 160e6,  80e6, 32, 32,  7.0 },
+	{ "usdhc3",      8e6,   4e6, 16, 16, 29.0 },
+	{ "enet",        5e6,   3e6, 16, 16,  5.0 },
+	{ "sdma-brst",   2e6,   2e6,  8,  8,  3.0 },
+};
+
+struct sim_state {
+	volatile uint32_t *regs;
+	struct timespec last;
+	uint64_t cnt[6];
+};
+
+static struct sim_state sim[2];
+static unsigned int sim_seed = 1;
+static double sim_hz = SIM_DDR_HZ;
+
+static struct sim_state *sim_find(volatile uint32_t *mmdc)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sim); i++)
+		if (sim[i].regs == mmdc)
+			return &sim[i];
+	return NULL;
+}
+
+static double sim_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* uniform noise in [-1, 1], reproducible across runs */
+static double sim_noise(void)
+{
+	return rand_r(&sim_seed) * 2.0 / RAND_MAX - 1.0;
+}
+
+static double sim_load(const struct sim_master *m, double t)
+{
+	double load = 1.0 + 0.1 * sim_noise();
+
+	if (m->period > 0.0)
+		load *= 0.6 + 0.4 * sin(2 * M_PI * t / m->period);
+	return load;
+}
+
+void *sim_map(unsigned int base)
+{
+	struct sim_state *st = NULL;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(sim); i++) {
+		if (!sim[i].regs) {
+			st = &sim[i];
+			break;
+		}
+	}
+	if (!st)
+		return NULL;
+
+	st->regs = calloc(1, PAGE_SIZE);
+	if (!st->regs)
+		return NULL;
+	/*
+	 * Only one controller is populated on the simulated board, keep
+	 * the second one idle with cycles left at 0.
+	 */
+	if (base == MMDC1_BASE)
+		st->last.tv_sec = -1;
+	return (void *)st->regs;
+}
+
+void sim_unmap(void *mem)
+{
+	struct sim_state *st = sim_find(mem);
+
+	if (st) {
+		free((void *)st->regs);
+		memset(st, 0, sizeof(*st));
+	}
+}
+
+void sim_reset(volatile uint32_t *mmdc)
+{
+	struct sim_state *st = sim_find(mmdc);
+	int i;
+
+	if (!st)
+		return;
+
+	/* CYC_OVF is write one to clear, plain memory needs help there */
+	mmdc[MMDC_MADPCR0 >> 2] &= ~MADPCR0_CYC_OVF;
+	memset(st->cnt, 0, sizeof(st->cnt));
+	for (i = 0; i < 6; i++)
+		mmdc[(MMDC_MADPSR0 >> 2) + i] = 0;
+	if (st->last.tv_sec != -1)
+		clock_gettime(CLOCK_MONOTONIC, &st->last);
+}
+
+/* DDR clock for a simulated operating point change, busy cycles stay */
+void sim_set_clock(double hz)
+{
+	sim_hz = hz;
+}
+
+/* Advance the counters by the traffic since the previous update */
+void sim_update(volatile uint32_t *mmdc)
+{
+	struct sim_state *st = sim_find(mmdc);
+	uint32_t pcr1 = mmdc[MMDC_MADPCR1 >> 2];
+	unsigned short id = pcr1 >> MADPCR1_PRF_AXI_ID_SHIFT;
+	unsigned short mask = pcr1 >> MADPCR1_PRF_AXI_ID_MASK_SHIFT;
+	double t, dt, total = 0.0, cycles;
+	unsigned int i;
+	int r;
+
+	if (!st || st->last.tv_sec == -1)
+		return;
+
+	t = sim_now();
+	dt = t - (st->last.tv_sec + st->last.tv_nsec * 1e-9);
+	clock_gettime(CLOCK_MONOTONIC, &st->last);
+	if (dt <= 0.0 || (mmdc[MMDC_MADPCR0 >> 2] & MADPCR0_PRF_FRZ))
+		return;
+
+	for (i = 0; i < ARRAY_SIZE(sim_masters); i++) {
+		const struct sim_master *m = &sim_masters[i];
+		const struct axi_filter *f = axi_filter_find(m->name);
+		double load = sim_load(m, t);
+		double rd = m->read_bps * load * dt;
+		double wr = m->write_bps * load * dt;
+
+		total += rd + wr;
+		if (!f || !axi_id_matches(f->axi_id, id, mask))
+			continue;
+
+		st->cnt[4] += rd;
+		st->cnt[5] += wr;
+		if (m->read_size)
+			st->cnt[2] += rd / m->read_size;
+		if (m->write_size)
+			st->cnt[3] += wr / m->write_size;
+	}
+
+	cycles = sim_hz * dt;
+	st->cnt[0] += cycles;
+	st->cnt[1] += fmin(total / SIM_BYTES_PER_BUSY, cycles);
+
+	if (st->cnt[0] > 0xffffffffull)
+		mmdc[MMDC_MADPCR0 >> 2] |= MADPCR0_CYC_OVF;
+	for (r = 0; r < 6; r++)
+		mmdc[(MMDC_MADPSR0 >> 2) + r] = st->cnt[r];
+}
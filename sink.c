@@ -0,0 +1,580 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Output sinks. The sampler hands every window to sinks_push(), which
+ * only copies it into the queue of each sink. Every sink has its own
+ * thread, format, decimation and queue, so a slow sink drops samples
+ * (or, with policy=block, holds back the next window) without affecting
+ * the others.
+ *
+ * --sink=FORMAT[:TARGET][,every=N][,queue=N][,batch=N][,policy=P]
+ *
+ *   FORMAT   text, pretty, csv, json, binary, serial, stream, energy
+ *            or web
+ *   TARGET   file name, '-' for stdout (default), tcp:// or udp:// URL
+ *            for the stream format, [HOST:]PORT for the web format
+ *   every    only pass every Nth window (default 1)
+ *   queue    samples buffered for this sink (default 256)
+ *   batch    samples handed over at once, files are flushed after each
+ *            batch (default 1 for stdout, 64 otherwise)
+ *   policy   drop (oldest, default), drop-new or block; block is the
+ *            default when replaying, no window of a recording is lost
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+
+#include "ddrstat_proto.h"
+#include "ddrstat_serial.h"
+
+#define SINK_BACKOFF_MIN_MS	100
+#define SINK_BACKOFF_MAX_MS	5000
+
+static struct sink *sinks;
+static volatile sig_atomic_t interrupted;
+static enum sink_policy default_policy = SINK_DROP;
+
+static const char *filter_name(const struct perf_sample *s)
+{
+	return s->filter ? s->filter->name : "all";
+}
+
+static void mmdc_print_pretty(FILE *f, const char *tag,
+			      const struct mmdc_stats *st)
+{
+	static const char * const unit[] = { "B", "KiB", "MiB", "GiB" };
+	unsigned long read_size = 0, write_size = 0;
+	unsigned long read_count = st->read_bytes;
+	unsigned long write_count = st->write_bytes;
+	int read_unit = 0, write_unit = 0;
+
+	if (st->read_accesses)
+		read_size = (read_count + st->read_accesses - 1) /
+			    st->read_accesses;
+	if (st->write_accesses)
+		write_size = (write_count + st->write_accesses - 1) /
+			     st->write_accesses;
+
+	while (read_count > 1023 && read_unit < 3) {
+		read_count /= 1024;
+		read_unit++;
+	}
+
+	while (write_count > 1023 && write_unit < 3) {
+		write_count /= 1024;
+		write_unit++;
+	}
+
+	fprintf(f, "%s %.2f%% busy %lu %s reads (%lu B / access) %lu %s writes (%lu B / access)",
+		tag, (double)100.0 * st->busy_cycles / st->cycles,
+		read_count, unit[read_unit], read_size,
+		write_count, unit[write_unit], write_size);
+}
+
+static void mmdc_print(FILE *f, bool pretty, const char *tag,
+		       const struct mmdc_stats *st)
+{
+	if (pretty)
+		mmdc_print_pretty(f, tag, st);
+	else
+		fprintf(f, "%s %.2f%% busy %u reads (%u bytes) %u writes (%u bytes)",
+			tag, (double)100.0 * st->busy_cycles / st->cycles,
+			st->read_accesses, st->read_bytes,
+			st->write_accesses, st->write_bytes);
+}
+
+static int print_write(struct sink *sk, bool pretty,
+		       const struct perf_sample *s, unsigned int n)
+{
+	for (; n; n--, s++) {
+		mmdc_print(sk->f, pretty, "MMDC0", &s->mmdc[0]);
+		if (s->mmdc[1].cycles) {
+			fprintf(sk->f, "\t");
+			mmdc_print(sk->f, pretty, "MMDC1", &s->mmdc[1]);
+		}
+		if (s->sweep)
+			fprintf(sk->f, "\t%s", filter_name(s));
+		if (s->suspended_ns)
+			fprintf(sk->f, "\tsuspended %.1f s",
+				s->suspended_ns * 1e-9);
+		fprintf(sk->f, "\n");
+	}
+	return 0;
+}
+
+static int text_write(struct sink *sk, uint32_t seq,
+		      const struct perf_sample *s, unsigned int n)
+{
+	(void)seq;
+	return print_write(sk, false, s, n);
+}
+
+static int pretty_write(struct sink *sk, uint32_t seq,
+			const struct perf_sample *s, unsigned int n)
+{
+	(void)seq;
+	return print_write(sk, true, s, n);
+}
+
+static int csv_open(struct sink *sk)
+{
+	int c;
+
+	fprintf(sk->f, "seq,duration_ns,filter,start_raw_ns,end_raw_ns,start_boot_ns,end_boot_ns,suspended_ns");
+	for (c = 0; c < 2; c++)
+		fprintf(sk->f, ",mmdc%d_cycles,mmdc%d_busy_cycles,mmdc%d_read_accesses,mmdc%d_write_accesses,mmdc%d_read_bytes,mmdc%d_write_bytes",
+			c, c, c, c, c, c);
+	fprintf(sk->f, ",corr_realtime_ns,corr_raw_ns,corr_boot_ns,corr_uncertainty_ns\n");
+	return 0;
+}
+
+static int csv_write(struct sink *sk, uint32_t seq,
+		     const struct perf_sample *s, unsigned int n)
+{
+	const struct mmdc_stats *st;
+	int c;
+
+	for (; n; n--, s++, seq++) {
+		fprintf(sk->f, "%u,%llu,%s,%llu,%llu,%llu,%llu,%llu", seq,
+			(unsigned long long)s->duration_ns, filter_name(s),
+			(unsigned long long)s->start_raw_ns,
+			(unsigned long long)s->end_raw_ns,
+			(unsigned long long)s->start_boot_ns,
+			(unsigned long long)s->end_boot_ns,
+			(unsigned long long)s->suspended_ns);
+		for (c = 0; c < 2; c++) {
+			st = &s->mmdc[c];
+			fprintf(sk->f, ",%u,%u,%u,%u,%u,%u", st->cycles,
+				st->busy_cycles, st->read_accesses,
+				st->write_accesses, st->read_bytes,
+				st->write_bytes);
+		}
+		if (s->has_corr)
+			fprintf(sk->f, ",%llu,%llu,%llu,%u",
+				(unsigned long long)s->corr.realtime_ns,
+				(unsigned long long)s->corr.raw_ns,
+				(unsigned long long)s->corr.boot_ns,
+				s->corr.uncertainty_ns);
+		else
+			fprintf(sk->f, ",,,,");
+		fprintf(sk->f, "\n");
+	}
+	return 0;
+}
+
+static int json_write(struct sink *sk, uint32_t seq,
+		      const struct perf_sample *s, unsigned int n)
+{
+	const struct mmdc_stats *st;
+	int c;
+
+	for (; n; n--, s++, seq++) {
+		fprintf(sk->f, "{\"seq\":%u,\"duration_ns\":%llu,\"filter\":\"%s\",\"start_raw_ns\":%llu,\"end_raw_ns\":%llu,\"start_boot_ns\":%llu,\"end_boot_ns\":%llu,\"suspended_ns\":%llu,\"mmdc\":[",
+			seq, (unsigned long long)s->duration_ns,
+			filter_name(s),
+			(unsigned long long)s->start_raw_ns,
+			(unsigned long long)s->end_raw_ns,
+			(unsigned long long)s->start_boot_ns,
+			(unsigned long long)s->end_boot_ns,
+			(unsigned long long)s->suspended_ns);
+		for (c = 0; c < 2; c++) {
+			st = &s->mmdc[c];
+			fprintf(sk->f, "%s{\"busy\":%.2f,\"cycles\":%u,\"busy_cycles\":%u,\"read_accesses\":%u,\"write_accesses\":%u,\"read_bytes\":%u,\"write_bytes\":%u}",
+				c ? "," : "", mmdc_busy(st), st->cycles,
+				st->busy_cycles, st->read_accesses,
+				st->write_accesses, st->read_bytes,
+				st->write_bytes);
+		}
+		fprintf(sk->f, "]");
+		if (s->has_corr)
+			fprintf(sk->f, ",\"corr\":{\"realtime_ns\":%llu,\"raw_ns\":%llu,\"boot_ns\":%llu,\"uncertainty_ns\":%u}",
+				(unsigned long long)s->corr.realtime_ns,
+				(unsigned long long)s->corr.raw_ns,
+				(unsigned long long)s->corr.boot_ns,
+				s->corr.uncertainty_ns);
+		fprintf(sk->f, "}\n");
+	}
+	return 0;
+}
+
+/* Recordings are a sequence of stream protocol batches */
+static int binary_write(struct sink *sk, uint32_t seq,
+			const struct perf_sample *s, unsigned int n)
+{
+	uint8_t buf[DDRSTAT_MAX_FRAME];
+	struct ddrstat_batch b = { 0 };
+	unsigned int i, count;
+	size_t len;
+
+	snprintf(b.device, sizeof(b.device), "%s", stream_device());
+	while (n) {
+		count = n > DDRSTAT_MAX_BATCH ? DDRSTAT_MAX_BATCH : n;
+		b.seq = seq;
+		b.count = count;
+		b.dropped = sk->dropped;
+		len = ddrstat_put_header(buf, &b);
+		for (i = 0; i < count; i++)
+			len += ddrstat_put_sample(buf + len, &s[i]);
+		if (fwrite(buf, len, 1, sk->f) != 1)
+			return -1;
+		s += count;
+		seq += count;
+		n -= count;
+	}
+	return 0;
+}
+
+/* One base64 line per window, for consoles */
+static int serial_write(struct sink *sk, uint32_t seq,
+			const struct perf_sample *s, unsigned int n)
+{
+	char line[DDRSTAT_SERIAL_LINE];
+	unsigned int i;
+	size_t len;
+
+	for (i = 0; i < n; i++) {
+		len = serial_encode(line, seq + i, &s[i]);
+		if (fwrite(line, len, 1, sk->f) != 1)
+			return -1;
+	}
+	return 0;
+}
+
+static const struct sink_ops sink_formats[] = {
+	{ "text",   NULL,        text_write,   NULL },
+	{ "pretty", NULL,        pretty_write, NULL },
+	{ "csv",    csv_open,    csv_write,    NULL },
+	{ "json",   NULL,        json_write,   NULL },
+	{ "binary", NULL,        binary_write, NULL },
+	{ "serial", NULL,        serial_write, NULL },
+	{ "stream", stream_open, stream_write, stream_close },
+	{ "energy", energy_open, energy_write, energy_close },
+	{ "web",    web_open,    web_write,    web_close },
+};
+
+static void deadline_after(struct timespec *ts, unsigned int ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (ms % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+static void *sink_thread(void *arg)
+{
+	struct sink *sk = arg;
+	unsigned int backoff = SINK_BACKOFF_MIN_MS;
+	struct perf_sample *batch;
+	struct timespec ts;
+	unsigned int i, n;
+	uint32_t seq;
+	int ret;
+
+	batch = calloc(sk->batch, sizeof(*batch));
+	if (!batch)
+		return NULL;
+
+	pthread_mutex_lock(&sk->lock);
+	for (;;) {
+		while (sk->running && sk->head == sk->tail)
+			pthread_cond_wait(&sk->more, &sk->lock);
+		if (sk->head == sk->tail)
+			break;
+
+		n = sk->head - sk->tail;
+		if (n > sk->batch)
+			n = sk->batch;
+		seq = sk->tail;
+		for (i = 0; i < n; i++)
+			batch[i] = sk->ring[(seq + i) % sk->queue];
+		pthread_mutex_unlock(&sk->lock);
+
+		ret = sk->ops->write(sk, seq, batch, n);
+		if (ret == 0 && sk->f)
+			ret = fflush(sk->f) ? -1 : 0;
+
+		pthread_mutex_lock(&sk->lock);
+		if (ret < 0) {
+			/* keep the samples, try again later */
+			if (!sk->running)
+				break;
+			deadline_after(&ts, backoff);
+			pthread_cond_timedwait(&sk->more, &sk->lock, &ts);
+			backoff *= 2;
+			if (backoff > SINK_BACKOFF_MAX_MS)
+				backoff = SINK_BACKOFF_MAX_MS;
+			continue;
+		}
+		backoff = SINK_BACKOFF_MIN_MS;
+
+		/* with policy=drop the sampler may have moved tail meanwhile */
+		if ((int32_t)(seq + n - sk->tail) > 0)
+			sk->tail = seq + n;
+		pthread_cond_signal(&sk->space);
+	}
+	pthread_mutex_unlock(&sk->lock);
+
+	free(batch);
+	return NULL;
+}
+
+static int sink_option(struct sink *sk, const char *opt)
+{
+	const char *val = strchr(opt, '=');
+	char *endp;
+	long n;
+
+	if (!val)
+		return -1;
+	val++;
+
+	if (strncmp(opt, "policy=", 7) == 0) {
+		if (strcmp(val, "drop") == 0)
+			sk->policy = SINK_DROP;
+		else if (strcmp(val, "drop-new") == 0)
+			sk->policy = SINK_DROP_NEW;
+		else if (strcmp(val, "block") == 0)
+			sk->policy = SINK_BLOCK;
+		else
+			return -1;
+		return 0;
+	}
+
+	n = strtol(val, &endp, 0);
+	if (*endp || n <= 0 || n > 1000000)
+		return -1;
+
+	if (strncmp(opt, "every=", 6) == 0)
+		sk->every = n;
+	else if (strncmp(opt, "queue=", 6) == 0)
+		sk->queue = n;
+	else if (strncmp(opt, "batch=", 6) == 0)
+		sk->batch = n;
+	else
+		return -1;
+	return 0;
+}
+
+/* Parse a --sink argument and start the sink */
+/* Policy of the sinks added from now on, unless they ask for another */
+void sinks_set_policy(enum sink_policy policy)
+{
+	default_policy = policy;
+}
+
+int sink_add(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *format, *target, *opts, *opt, *saveptr;
+	struct sink *sk, **tail;
+	sigset_t set, old;
+	unsigned int i;
+	int err;
+
+	sk = calloc(1, sizeof(*sk));
+	if (!copy || !sk)
+		goto err;
+
+	format = copy;
+	opts = strchr(copy, ',');
+	if (opts)
+		*opts++ = '\0';
+	target = strchr(copy, ':');
+	if (target)
+		*target++ = '\0';
+
+	for (i = 0; i < ARRAY_SIZE(sink_formats); i++)
+		if (strcmp(sink_formats[i].format, format) == 0)
+			sk->ops = &sink_formats[i];
+	if (!sk->ops) {
+		fprintf(stderr, "unknown sink format '%s'\n", format);
+		goto err;
+	}
+
+	sk->target = strdup(target && *target ? target : "-");
+	sk->every = 1;
+	sk->queue = 256;
+	sk->policy = default_policy;
+	sk->batch = strcmp(sk->target, "-") == 0 ? 1 : 64;
+	if (sk->ops->open == stream_open)
+		sk->batch = DDRSTAT_MAX_BATCH;
+	/* console lines are wanted as they come */
+	if (sk->ops->write == serial_write)
+		sk->batch = 1;
+
+	for (opt = opts ? strtok_r(opts, ",", &saveptr) : NULL; opt;
+	     opt = strtok_r(NULL, ",", &saveptr)) {
+		if (sink_option(sk, opt)) {
+			fprintf(stderr, "invalid sink option '%s'\n", opt);
+			goto err;
+		}
+	}
+	if (sk->batch > sk->queue)
+		sk->batch = sk->queue;
+
+	sk->ring = calloc(sk->queue, sizeof(*sk->ring));
+	if (!sk->target || !sk->ring)
+		goto err;
+
+	if (sk->ops->open != stream_open && sk->ops->open != web_open) {
+		sk->f = strcmp(sk->target, "-") == 0 ? stdout :
+			fopen(sk->target, "w");
+		if (!sk->f) {
+			perror(sk->target);
+			goto err;
+		}
+	}
+	if (sk->ops->open && sk->ops->open(sk))
+		goto err;
+
+	pthread_mutex_init(&sk->lock, NULL);
+	pthread_cond_init(&sk->more, NULL);
+	pthread_cond_init(&sk->space, NULL);
+
+	/* leave SIGINT and SIGTERM to the sampling loop */
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+	sk->running = true;
+	err = pthread_create(&sk->thread, NULL, sink_thread, sk);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	if (err) {
+		if (sk->ops->close)
+			sk->ops->close(sk);
+		goto err;
+	}
+
+	for (tail = &sinks; *tail; tail = &(*tail)->next)
+		;
+	*tail = sk;
+	free(copy);
+	return 0;
+err:
+	if (sk) {
+		if (sk->f && sk->f != stdout)
+			fclose(sk->f);
+		free(sk->ring);
+		free(sk->target);
+		free(sk);
+	}
+	free(copy);
+	return -1;
+}
+
+/* Called from signal handlers, stops blocking sinks from holding us up */
+void sinks_interrupt(void)
+{
+	interrupted = 1;
+}
+
+bool sinks_active(void)
+{
+	return sinks != NULL;
+}
+
+void sinks_push(const struct perf_sample *s)
+{
+	struct timespec ts;
+	struct sink *sk;
+
+	for (sk = sinks; sk; sk = sk->next) {
+		if (sk->seen++ % sk->every)
+			continue;
+
+		pthread_mutex_lock(&sk->lock);
+		while (sk->policy == SINK_BLOCK && !interrupted &&
+		       sk->head - sk->tail == sk->queue) {
+			deadline_after(&ts, 100);
+			pthread_cond_timedwait(&sk->space, &sk->lock, &ts);
+		}
+		if (sk->head - sk->tail == sk->queue) {
+			if (sk->policy == SINK_DROP_NEW) {
+				sk->dropped++;
+				pthread_mutex_unlock(&sk->lock);
+				continue;
+			}
+			sk->tail++;
+			sk->dropped++;
+		}
+		sk->ring[sk->head % sk->queue] = *s;
+		sk->head++;
+		pthread_cond_signal(&sk->more);
+		pthread_mutex_unlock(&sk->lock);
+	}
+}
+
+unsigned int sinks_count(void)
+{
+	struct sink *sk;
+	unsigned int n = 0;
+
+	for (sk = sinks; sk; sk = sk->next)
+		n++;
+	return n;
+}
+
+/* Drain and close all sinks but the first keep ones */
+void sinks_trim(unsigned int keep)
+{
+	struct sink *sk, *next, **tail = &sinks;
+
+	while (*tail && keep--)
+		tail = &(*tail)->next;
+
+	for (sk = *tail; sk; sk = next) {
+		next = sk->next;
+
+		pthread_mutex_lock(&sk->lock);
+		sk->running = false;
+		pthread_cond_signal(&sk->more);
+		pthread_mutex_unlock(&sk->lock);
+		pthread_join(sk->thread, NULL);
+
+		if (sk->ops->close)
+			sk->ops->close(sk);
+		if (sk->f && sk->f != stdout)
+			fclose(sk->f);
+		if (sk->dropped)
+			fprintf(stderr, "%s sink %s: %llu samples dropped\n",
+				sk->ops->format, sk->target,
+				(unsigned long long)sk->dropped);
+		free(sk->ring);
+		free(sk->target);
+		free(sk);
+	}
+	*tail = NULL;
+}
+
+/* Drain and close all sinks */
+void sinks_exit(void)
+{
+	sinks_trim(0);
+}
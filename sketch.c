@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sketch.h"
+
+#define SKETCH_GAMMA	((1.0 + SKETCH_ALPHA) / (1.0 - SKETCH_ALPHA))
+
+static int sketch_index(double v)
+{
+	int i = ceil(log(v / SKETCH_MIN) / log(SKETCH_GAMMA));
+
+	if (i < 0)
+		i = 0;
+	if (i >= SKETCH_BUCKETS)
+		i = SKETCH_BUCKETS - 1;
+	return i;
+}
+
+/* the value at the centre of bucket i, relative error below alpha */
+static double sketch_value(int i)
+{
+	return SKETCH_MIN * 2.0 * pow(SKETCH_GAMMA, i) / (SKETCH_GAMMA + 1.0);
+}
+
+void sketch_init(struct sketch *s)
+{
+	memset(s, 0, sizeof(*s));
+}
+
+void sketch_add(struct sketch *s, double v)
+{
+	if (s->count == 0 || v < s->min)
+		s->min = v;
+	if (s->count == 0 || v > s->max)
+		s->max = v;
+	s->count++;
+	s->sum += v;
+
+	if (v < SKETCH_MIN)
+		s->zero++;
+	else
+		s->bucket[sketch_index(v)]++;
+}
+
+void sketch_merge(struct sketch *dst, const struct sketch *src)
+{
+	int i;
+
+	if (!src->count)
+		return;
+
+	if (dst->count == 0 || src->min < dst->min)
+		dst->min = src->min;
+	if (dst->count == 0 || src->max > dst->max)
+		dst->max = src->max;
+	dst->count += src->count;
+	dst->zero += src->zero;
+	dst->sum += src->sum;
+	for (i = 0; i < SKETCH_BUCKETS; i++)
+		dst->bucket[i] += src->bucket[i];
+}
+
+double sketch_quantile(const struct sketch *s, double q)
+{
+	uint64_t rank, seen;
+	int i;
+
+	if (!s->count)
+		return 0.0;
+	if (q <= 0.0)
+		return s->min;
+	if (q >= 1.0)
+		return s->max;
+
+	rank = q * (s->count - 1);
+	seen = s->zero;
+	if (rank < seen)
+		return 0.0;
+
+	for (i = 0; i < SKETCH_BUCKETS; i++) {
+		seen += s->bucket[i];
+		if (rank < seen)
+			return fmin(fmax(sketch_value(i), s->min), s->max);
+	}
+
+	return s->max;
+}
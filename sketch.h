@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <stdint.h>
+
+/*
+ * Mergeable quantile sketch with bounded relative error: positive values
+ * are counted in logarithmically spaced buckets, so every quantile is
+ * reported within SKETCH_ALPHA of the true value. Values below
+ * SKETCH_MIN are counted as zero, values above SKETCH_MAX clamp.
+ */
+
+#define SKETCH_ALPHA	0.01
+#define SKETCH_MIN	1e-3
+#define SKETCH_MAX	1e12
+#define SKETCH_BUCKETS	1730
+
+struct sketch {
+	uint64_t count;
+	uint64_t zero;
+	double min;
+	double max;
+	double sum;
+	uint32_t bucket[SKETCH_BUCKETS];
+};
+
+void sketch_init(struct sketch *s);
+void sketch_add(struct sketch *s, double v);
+void sketch_merge(struct sketch *dst, const struct sketch *src);
+double sketch_quantile(const struct sketch *s, double q);
+
+#endif
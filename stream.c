@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Stream sink, sends samples to a host side collector. Runs on its own
+ * sink thread, so connecting and sending never delay a profiling window;
+ * while the collector is unreachable the sink framework keeps the
+ * samples queued and retries with backoff.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "ddrstat_proto.h"
+
+#define STREAM_CONNECT_MS	2000
+
+struct stream {
+	int socktype;
+	char host[256];
+	char port[16];
+	int fd;
+};
+
+static char device[DDRSTAT_DEVICE_LEN + 1];
+
+static int parse_url(struct stream *st, const char *url)
+{
+	const char *p;
+	const char *colon;
+	size_t len;
+
+	if (strncmp(url, "tcp://", 6) == 0)
+		st->socktype = SOCK_STREAM;
+	else if (strncmp(url, "udp://", 6) == 0)
+		st->socktype = SOCK_DGRAM;
+	else
+		return -1;
+	p = url + 6;
+
+	if (*p == '[') {
+		colon = strchr(p, ']');
+		if (!colon)
+			return -1;
+		len = colon - p - 1;
+		p++;
+		colon = colon[1] == ':' ? colon + 1 : NULL;
+	} else {
+		colon = strrchr(p, ':');
+		len = colon ? (size_t)(colon - p) : strlen(p);
+	}
+
+	if (len == 0 || len >= sizeof(st->host))
+		return -1;
+	memcpy(st->host, p, len);
+	st->host[len] = '\0';
+
+	if (colon)
+		snprintf(st->port, sizeof(st->port), "%s", colon + 1);
+	else
+		snprintf(st->port, sizeof(st->port), "%d", DDRSTAT_PORT);
+
+	return 0;
+}
+
+static int connect_timeout(int s, const struct sockaddr *addr,
+			   socklen_t len)
+{
+	struct pollfd pfd = { .fd = s, .events = POLLOUT };
+	int flags = fcntl(s, F_GETFL);
+	int err = 0;
+	socklen_t errlen = sizeof(err);
+
+	fcntl(s, F_SETFL, flags | O_NONBLOCK);
+	if (connect(s, addr, len) < 0) {
+		if (errno != EINPROGRESS)
+			return -1;
+		if (poll(&pfd, 1, STREAM_CONNECT_MS) <= 0)
+			return -1;
+		if (getsockopt(s, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0 ||
+		    err)
+			return -1;
+	}
+	fcntl(s, F_SETFL, flags);
+
+	return 0;
+}
+
+static int stream_connect(struct stream *st)
+{
+	struct addrinfo hints, *res, *ai;
+	struct timeval tv = { .tv_sec = 2 };
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = st->socktype;
+
+	if (getaddrinfo(st->host, st->port, &hints, &res))
+		return -1;
+
+	for (ai = res; ai; ai = ai->ai_next) {
+		st->fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC,
+				ai->ai_protocol);
+		if (st->fd < 0)
+			continue;
+		if (connect_timeout(st->fd, ai->ai_addr, ai->ai_addrlen) == 0)
+			break;
+		close(st->fd);
+		st->fd = -1;
+	}
+	freeaddrinfo(res);
+
+	if (st->fd < 0)
+		return -1;
+
+	/* don't let a stalled collector hold the thread forever */
+	setsockopt(st->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	return 0;
+}
+
+static int send_all(int fd, const uint8_t *buf, size_t len)
+{
+	while (len) {
+		ssize_t ret = send(fd, buf, len, MSG_NOSIGNAL);
+
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		buf += ret;
+		len -= ret;
+	}
+	return 0;
+}
+
+/* Names this instance towards the collector, defaults to the host name */
+void stream_set_device(const char *name)
+{
+	snprintf(device, sizeof(device), "%s", name);
+}
+
+const char *stream_device(void)
+{
+	if (!device[0] && gethostname(device, sizeof(device) - 1))
+		strcpy(device, "imx6");
+	return device;
+}
+
+/* target is tcp://host[:port] or udp://host[:port] */
+int stream_open(struct sink *sk)
+{
+	struct stream *st = calloc(1, sizeof(*st));
+
+	if (!st)
+		return -1;
+	if (parse_url(st, sk->target)) {
+		fprintf(stderr, "invalid stream url '%s'\n", sk->target);
+		free(st);
+		return -1;
+	}
+	st->fd = -1;
+	sk->priv = st;
+	stream_device();
+
+	return 0;
+}
+
+int stream_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+		 unsigned int n)
+{
+	struct stream *st = sk->priv;
+	uint8_t buf[DDRSTAT_MAX_FRAME];
+	struct ddrstat_batch b = { 0 };
+	unsigned int i, count;
+	size_t len;
+
+	if (st->fd < 0 && stream_connect(st) < 0)
+		return -1;
+
+	snprintf(b.device, sizeof(b.device), "%s", device);
+	while (n) {
+		count = n > DDRSTAT_MAX_BATCH ? DDRSTAT_MAX_BATCH : n;
+		b.seq = seq;
+		b.count = count;
+		b.dropped = sk->dropped;
+		len = ddrstat_put_header(buf, &b);
+		for (i = 0; i < count; i++)
+			len += ddrstat_put_sample(buf + len, &s[i]);
+
+		if (send_all(st->fd, buf, len) < 0) {
+			close(st->fd);
+			st->fd = -1;
+			return -1;
+		}
+		s += count;
+		seq += count;
+		n -= count;
+	}
+
+	return 0;
+}
+
+void stream_close(struct sink *sk)
+{
+	struct stream *st = sk->priv;
+
+	if (st->fd >= 0)
+		close(st->fd);
+	free(st);
+	sk->priv = NULL;
+}
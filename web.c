@@ -0,0 +1,524 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Web sink, a live chart for a browser. A single server thread runs an
+ * epoll loop over the listening socket, the clients and an eventfd; it
+ * serves the page on / and pushes windows as server-sent events on
+ * /events.
+ *
+ * The sink thread formats each batch of windows once into a shared
+ * buffer and kicks the eventfd, so sampling never waits on the network
+ * and every extra browser costs one send() of the same bytes. A client
+ * that cannot keep up with WEB_CLIENT_BACKLOG bytes is disconnected.
+ *
+ * --sink=web[:[HOST:]PORT]   (default port 8080 on all addresses)
+ */
+
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include "ddrstat_proto.h"
+#include "imx6_ddrstat.h"
+
+#define WEB_PORT		"8080"
+#define WEB_MAX_CLIENTS		32
+#define WEB_REQUEST_SIZE	2048
+#define WEB_PENDING_SIZE	65536
+#define WEB_CLIENT_BACKLOG	262144
+
+struct web_client {
+	int fd;
+	bool events;		/* subscribed to /events */
+	bool done;		/* close once out is sent */
+	char req[WEB_REQUEST_SIZE];
+	size_t req_len;
+	char *out;
+	size_t out_len;
+};
+
+struct web {
+	int listen_fd;
+	int epfd;
+	int evfd;
+	pthread_t thread;
+
+	/* formatted events not yet sent, protected by lock */
+	pthread_mutex_t lock;
+	char pending[WEB_PENDING_SIZE];
+	size_t pending_len;
+	uint64_t overruns;
+	bool stop;
+
+	struct web_client *clients[WEB_MAX_CLIENTS];
+
+	/* the device name as a JSON string body */
+	char device[DDRSTAT_DEVICE_LEN * 6 + 1];
+};
+
+static const char page[] =
+	"<!DOCTYPE html>\n"
+	"<html><head><meta charset=\"utf-8\"><title>imx6_ddrstat</title>\n"
+	"<style>body{font-family:sans-serif;margin:1em}canvas{border:1px solid #ccc}"
+	"#now{font-family:monospace;margin:.5em 0}</style></head>\n"
+	"<body><h3 id=\"dev\">imx6_ddrstat</h3><div id=\"now\">waiting for data</div>\n"
+	"<canvas id=\"busy\" width=\"720\" height=\"180\"></canvas><br>\n"
+	"<canvas id=\"bw\" width=\"720\" height=\"180\"></canvas>\n"
+	"<script>\n"
+	"var N=240,hist=[];\n"
+	"function plot(id,keys,colors,fixed){var c=document.getElementById(id),g=c.getContext('2d');"
+	"var max=fixed||1;if(!fixed)hist.forEach(function(h){keys.forEach(function(k){max=Math.max(max,h[k]);});});"
+	"g.clearRect(0,0,c.width,c.height);g.fillStyle='#666';g.fillText(max.toFixed(0),2,10);"
+	"keys.forEach(function(k,i){g.strokeStyle=colors[i];g.beginPath();"
+	"hist.forEach(function(h,x){var y=c.height-h[k]/max*(c.height-12);"
+	"x=x*c.width/N;if(x)g.lineTo(x,y);else g.moveTo(x,y);});g.stroke();"
+	"g.fillStyle=colors[i];g.fillText(k,40+60*i,10);});}\n"
+	"var es=new EventSource('events');\n"
+	"es.onmessage=function(e){var d=JSON.parse(e.data);"
+	"if(d.filter!='all'||d.suspended)return;"
+	"hist.push(d);if(hist.length>N)hist.shift();"
+	"document.getElementById('now').textContent='busy '+d.busy0.toFixed(1)+'% / '+d.busy1.toFixed(1)+"
+	"'%  read '+d.read.toFixed(1)+' MB/s  write '+d.write.toFixed(1)+' MB/s';"
+	"plot('busy',['busy0','busy1'],['#c00','#06c'],100);"
+	"plot('bw',['read','write'],['#080','#a60']);};\n"
+	"es.onerror=function(){document.getElementById('now').textContent='disconnected, retrying';};\n"
+	"</script></body></html>\n";
+
+/* Escape a string for use between double quotes in JSON */
+static void json_escape(char *out, size_t size, const char *in)
+{
+	size_t len = 0;
+
+	for (; *in && len + 7 <= size; in++) {
+		if (*in == '"' || *in == '\\')
+			len += sprintf(out + len, "\\%c", *in);
+		else if ((unsigned char)*in < 0x20)
+			len += sprintf(out + len, "\\u%04x", *in);
+		else
+			out[len++] = *in;
+	}
+	out[len] = '\0';
+}
+
+static int web_listen(const char *target)
+{
+	struct addrinfo hints, *res, *ai;
+	const char *port = target, *colon;
+	char host[256];
+	int one = 1;
+	int fd = -1;
+
+	host[0] = '\0';
+	colon = strrchr(target, ':');
+	if (colon) {
+		snprintf(host, sizeof(host), "%.*s", (int)(colon - target),
+			 target);
+		port = colon + 1;
+	}
+	if (strcmp(target, "-") == 0 || !*port)
+		port = WEB_PORT;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	if (getaddrinfo(host[0] ? host : NULL, port, &hints, &res))
+		return -1;
+
+	for (ai = res; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC |
+			    SOCK_NONBLOCK, 0);
+		if (fd < 0)
+			continue;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 &&
+		    listen(fd, 16) == 0)
+			break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
+static void client_close(struct web *w, unsigned int i)
+{
+	struct web_client *c = w->clients[i];
+
+	close(c->fd);
+	free(c->out);
+	free(c);
+	w->clients[i] = NULL;
+}
+
+/* Send what fits now and keep the rest, -1 if the client has to go */
+static int client_send(struct web *w, unsigned int i, const char *buf,
+		       size_t len)
+{
+	struct web_client *c = w->clients[i];
+	struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i };
+	ssize_t ret;
+	char *out;
+
+	/* only send directly if nothing older is still queued */
+	if (!c->out_len) {
+		ret = send(c->fd, buf, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (ret < 0 && errno != EAGAIN && errno != EINTR)
+			return -1;
+		if (ret > 0) {
+			buf += ret;
+			len -= ret;
+		}
+	}
+	if (!len)
+		return 0;
+
+	if (c->out_len + len > WEB_CLIENT_BACKLOG)
+		return -1;
+	out = realloc(c->out, c->out_len + len);
+	if (!out)
+		return -1;
+	memcpy(out + c->out_len, buf, len);
+	c->out = out;
+	c->out_len += len;
+
+	ev.events |= EPOLLOUT;
+	epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+	return 0;
+}
+
+static void client_flush(struct web *w, unsigned int i)
+{
+	struct web_client *c = w->clients[i];
+	struct epoll_event ev = { .events = EPOLLIN, .data.u32 = i };
+	ssize_t ret;
+
+	ret = send(c->fd, c->out, c->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (ret < 0 && errno != EAGAIN && errno != EINTR) {
+		client_close(w, i);
+		return;
+	}
+	if (ret > 0) {
+		memmove(c->out, c->out + ret, c->out_len - ret);
+		c->out_len -= ret;
+	}
+	if (c->out_len)
+		return;
+
+	if (c->done) {
+		client_close(w, i);
+		return;
+	}
+	epoll_ctl(w->epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void client_respond(struct web *w, unsigned int i)
+{
+	struct web_client *c = w->clients[i];
+	char head[256];
+	int len;
+
+	if (strncmp(c->req, "GET /events ", 12) == 0) {
+		static const char sse[] =
+			"HTTP/1.1 200 OK\r\n"
+			"Content-Type: text/event-stream\r\n"
+			"Cache-Control: no-cache\r\n"
+			"Connection: keep-alive\r\n"
+			"\r\n"
+			"retry: 2000\n\n";
+
+		c->events = true;
+		if (client_send(w, i, sse, sizeof(sse) - 1))
+			client_close(w, i);
+		return;
+	}
+
+	if (strncmp(c->req, "GET / ", 6) == 0) {
+		len = snprintf(head, sizeof(head),
+			       "HTTP/1.1 200 OK\r\n"
+			       "Content-Type: text/html\r\n"
+			       "Content-Length: %zu\r\n"
+			       "Connection: close\r\n"
+			       "\r\n", sizeof(page) - 1);
+		c->done = true;
+		if (client_send(w, i, head, len) ||
+		    client_send(w, i, page, sizeof(page) - 1))
+			client_close(w, i);
+		else if (!c->out_len)
+			client_close(w, i);
+		return;
+	}
+
+	len = snprintf(head, sizeof(head),
+		       "HTTP/1.1 404 Not Found\r\n"
+		       "Content-Length: 0\r\n"
+		       "Connection: close\r\n"
+		       "\r\n");
+	c->done = true;
+	if (client_send(w, i, head, len) || !c->out_len)
+		client_close(w, i);
+}
+
+static void client_read(struct web *w, unsigned int i)
+{
+	struct web_client *c = w->clients[i];
+	ssize_t ret;
+
+	ret = recv(c->fd, c->req + c->req_len,
+		   sizeof(c->req) - 1 - c->req_len, MSG_DONTWAIT);
+	if (ret <= 0) {
+		if (ret == 0 || (errno != EAGAIN && errno != EINTR))
+			client_close(w, i);
+		return;
+	}
+
+	/* subscribers have nothing more to say */
+	if (c->events || c->done)
+		return;
+
+	c->req_len += ret;
+	c->req[c->req_len] = '\0';
+	if (strstr(c->req, "\r\n\r\n") || strstr(c->req, "\n\n"))
+		client_respond(w, i);
+	else if (c->req_len == sizeof(c->req) - 1)
+		client_close(w, i);
+}
+
+static void web_accept(struct web *w)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+	struct web_client *c;
+	unsigned int i;
+	int fd;
+
+	fd = accept4(w->listen_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+	if (fd < 0)
+		return;
+
+	for (i = 0; i < WEB_MAX_CLIENTS; i++)
+		if (!w->clients[i])
+			break;
+	c = i < WEB_MAX_CLIENTS ? calloc(1, sizeof(*c)) : NULL;
+	if (!c) {
+		close(fd);
+		return;
+	}
+	c->fd = fd;
+	w->clients[i] = c;
+
+	ev.data.u32 = i;
+	if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev))
+		client_close(w, i);
+}
+
+/* Hand the formatted events to every subscriber */
+static void web_broadcast(struct web *w)
+{
+	static char buf[WEB_PENDING_SIZE];
+	unsigned int i;
+	uint64_t kicks;
+	size_t len;
+
+	if (read(w->evfd, &kicks, sizeof(kicks)) < 0)
+		return;
+
+	pthread_mutex_lock(&w->lock);
+	len = w->pending_len;
+	memcpy(buf, w->pending, len);
+	w->pending_len = 0;
+	pthread_mutex_unlock(&w->lock);
+
+	for (i = 0; i < WEB_MAX_CLIENTS; i++) {
+		if (!w->clients[i] || !w->clients[i]->events)
+			continue;
+		if (client_send(w, i, buf, len))
+			client_close(w, i);
+	}
+}
+
+#define WEB_LISTEN	(WEB_MAX_CLIENTS)
+#define WEB_EVENT	(WEB_MAX_CLIENTS + 1)
+
+static void *web_thread(void *arg)
+{
+	struct web *w = arg;
+	struct epoll_event ev[16];
+	unsigned int i;
+	uint32_t id;
+	int n;
+
+	for (;;) {
+		n = epoll_wait(w->epfd, ev, ARRAY_SIZE(ev), -1);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0)
+			break;
+
+		for (i = 0; i < (unsigned int)n; i++) {
+			id = ev[i].data.u32;
+			if (id == WEB_LISTEN) {
+				web_accept(w);
+			} else if (id == WEB_EVENT) {
+				web_broadcast(w);
+			} else if (w->clients[id]) {
+				if (ev[i].events & (EPOLLERR | EPOLLHUP)) {
+					client_close(w, id);
+					continue;
+				}
+				if (ev[i].events & EPOLLOUT)
+					client_flush(w, id);
+				if (w->clients[id] && ev[i].events & EPOLLIN)
+					client_read(w, id);
+			}
+		}
+
+		pthread_mutex_lock(&w->lock);
+		if (w->stop) {
+			pthread_mutex_unlock(&w->lock);
+			break;
+		}
+		pthread_mutex_unlock(&w->lock);
+	}
+
+	for (i = 0; i < WEB_MAX_CLIENTS; i++)
+		if (w->clients[i])
+			client_close(w, i);
+	return NULL;
+}
+
+int web_open(struct sink *sk)
+{
+	struct epoll_event ev = { .events = EPOLLIN };
+	struct web *w = calloc(1, sizeof(*w));
+	sigset_t set, old;
+	int err;
+
+	if (!w)
+		return -1;
+	w->listen_fd = web_listen(sk->target);
+	if (w->listen_fd < 0) {
+		fprintf(stderr, "cannot listen on '%s'\n", sk->target);
+		free(w);
+		return -1;
+	}
+	w->epfd = epoll_create1(EPOLL_CLOEXEC);
+	w->evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	pthread_mutex_init(&w->lock, NULL);
+
+	ev.data.u32 = WEB_LISTEN;
+	err = w->epfd < 0 || w->evfd < 0 ||
+	      epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->listen_fd, &ev);
+	ev.data.u32 = WEB_EVENT;
+	err = err || epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->evfd, &ev);
+
+	if (!err) {
+		sigfillset(&set);
+		pthread_sigmask(SIG_BLOCK, &set, &old);
+		err = pthread_create(&w->thread, NULL, web_thread, w);
+		pthread_sigmask(SIG_SETMASK, &old, NULL);
+	}
+	if (err) {
+		close(w->listen_fd);
+		if (w->epfd >= 0)
+			close(w->epfd);
+		if (w->evfd >= 0)
+			close(w->evfd);
+		free(w);
+		return -1;
+	}
+
+	sk->priv = w;
+	json_escape(w->device, sizeof(w->device), stream_device());
+	return 0;
+}
+
+/* Format the windows once for all subscribers, never blocks */
+int web_write(struct sink *sk, uint32_t seq, const struct perf_sample *s,
+	      unsigned int n)
+{
+	struct web *w = sk->priv;
+	const struct mmdc_stats *m0, *m1;
+	uint64_t kick = 1;
+	char ev[512 + sizeof(w->device)];
+	int len;
+
+	pthread_mutex_lock(&w->lock);
+	for (; n; n--, s++, seq++) {
+		m0 = &s->mmdc[0];
+		m1 = &s->mmdc[1];
+		len = snprintf(ev, sizeof(ev),
+			       "data: {\"seq\":%u,\"device\":\"%s\",\"filter\":\"%s\",\"duration_ms\":%.1f,\"suspended\":%s,\"busy0\":%.2f,\"busy1\":%.2f,\"read\":%.2f,\"write\":%.2f}\n\n",
+			       seq, w->device,
+			       s->filter ? s->filter->name : "all",
+			       s->duration_ns / 1e6,
+			       s->suspended_ns ? "true" : "false",
+			       mmdc_busy(m0), mmdc_busy(m1),
+			       (perf_rate(s, m0->read_bytes) +
+				perf_rate(s, m1->read_bytes)) / 1e6,
+			       (perf_rate(s, m0->write_bytes) +
+				perf_rate(s, m1->write_bytes)) / 1e6);
+		/* the server thread is stuck, browsers will see a gap */
+		if (w->pending_len + len > sizeof(w->pending)) {
+			w->pending_len = 0;
+			w->overruns++;
+		}
+		memcpy(w->pending + w->pending_len, ev, len);
+		w->pending_len += len;
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	if (write(w->evfd, &kick, sizeof(kick)) < 0 && errno != EAGAIN)
+		return -1;
+	return 0;
+}
+
+void web_close(struct sink *sk)
+{
+	struct web *w = sk->priv;
+	uint64_t kick = 1;
+
+	pthread_mutex_lock(&w->lock);
+	w->stop = true;
+	pthread_mutex_unlock(&w->lock);
+	if (write(w->evfd, &kick, sizeof(kick)) < 0)
+		pthread_cancel(w->thread);
+	pthread_join(w->thread, NULL);
+
+	if (w->overruns)
+		fprintf(stderr, "web sink: %llu event overruns\n",
+			(unsigned long long)w->overruns);
+	close(w->listen_fd);
+	close(w->epfd);
+	close(w->evfd);
+	pthread_mutex_destroy(&w->lock);
+	free(w);
+	sk->priv = NULL;
+}
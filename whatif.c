@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2026 imx6_ddrstat contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Capacity what-if projection. Unfiltered windows fit a linear model of
+ * busy% over the total bandwidth, filtered windows from the sweep give
+ * the bandwidth of every master. Scaling some masters then moves the
+ * total bandwidth, which the model turns into a projected busy% and
+ * headroom, and the point where busy% reaches the limit.
+ *
+ * --whatif=MASTER*FACTOR[,MASTER*FACTOR...][,limit=PERCENT]
+ *
+ * A frame rate change is a factor too: a VPU going from 30 to 60 fps is
+ * vpu-prime*2. The report is printed on exit.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imx6_ddrstat.h"
+
+struct whatif_scale {
+	const struct axi_filter *filter;
+	double factor;
+};
+
+static struct whatif_scale scales[16];
+static unsigned int num_scales;
+static double limit = 100.0;
+static bool enabled;
+
+/* least squares sums of busy% (y) over total MB/s (x) */
+static double n, sx, sy, sxx, sxy, syy;
+
+/* per master MB/s sums, indexed like perf_totals */
+static double master_sum[64];
+static unsigned int master_windows[64];
+
+int whatif_init(const char *spec)
+{
+	char *copy = strdup(spec);
+	char *item, *star, *end, *saveptr;
+	const struct axi_filter *filter;
+	double v;
+
+	if (!copy)
+		return -1;
+
+	for (item = strtok_r(copy, ",", &saveptr); item;
+	     item = strtok_r(NULL, ",", &saveptr)) {
+		if (strncmp(item, "limit=", 6) == 0) {
+			limit = strtod(item + 6, &end);
+			if (*end || limit <= 0.0 || limit > 100.0)
+				goto bad;
+			continue;
+		}
+
+		star = strchr(item, '*');
+		if (!star || num_scales == ARRAY_SIZE(scales))
+			goto bad;
+		*star++ = '\0';
+		v = strtod(star, &end);
+		if (*end || v < 0.0)
+			goto bad;
+		filter = axi_filter_find(item);
+		if (!filter) {
+			fprintf(stderr, "unknown AXI master '%s'\n", item);
+			goto err;
+		}
+		scales[num_scales].filter = filter;
+		scales[num_scales].factor = v;
+		num_scales++;
+	}
+
+	if (!num_scales)
+		goto bad;
+
+	free(copy);
+	enabled = true;
+	return 0;
+bad:
+	fprintf(stderr, "invalid what-if '%s'\n", spec);
+err:
+	free(copy);
+	return -1;
+}
+
+/* Comma separated list of the masters to sweep for the projection */
+int whatif_sweep_list(char *buf, size_t size)
+{
+	size_t len = snprintf(buf, size, "all");
+	unsigned int i;
+
+	for (i = 0; i < num_scales && len < size; i++)
+		len += snprintf(buf + len, size - len, ",%s",
+				scales[i].filter->name);
+	return len < size ? 0 : -1;
+}
+
+static double total_mbps(const struct perf_sample *s)
+{
+	return perf_rate(s, s->mmdc[0].read_bytes + s->mmdc[0].write_bytes +
+			 s->mmdc[1].read_bytes + s->mmdc[1].write_bytes) / 1e6;
+}
+
+void whatif_account(const struct perf_sample *s)
+{
+	unsigned int i;
+	double x, y;
+
+	if (!enabled || s->suspended_ns || !s->duration_ns)
+		return;
+
+	x = total_mbps(s);
+	if (s->filter) {
+		i = s->filter - filters + 1;
+		master_sum[i] += x;
+		master_windows[i]++;
+		return;
+	}
+
+	y = fmax(mmdc_busy(&s->mmdc[0]), mmdc_busy(&s->mmdc[1]));
+	n++;
+	sx += x;
+	sy += y;
+	sxx += x * x;
+	sxy += x * y;
+	syy += y * y;
+}
+
+static double busy_at(double a, double b, double x)
+{
+	return a + b * x;
+}
+
+void whatif_report(FILE *f)
+{
+	double a, b, r2, var_x, var_y, cov, x, extra = 0.0, mbps, busy;
+	double k;
+	unsigned int i, idx;
+
+	if (!enabled)
+		return;
+	if (n < 2) {
+		fprintf(f, "what-if: not enough unfiltered windows\n");
+		return;
+	}
+
+	var_x = sxx - sx * sx / n;
+	var_y = syy - sy * sy / n;
+	cov = sxy - sx * sy / n;
+	if (var_x > 1e-9) {
+		b = cov / var_x;
+		a = (sy - b * sx) / n;
+		r2 = var_y > 1e-9 ? cov * cov / (var_x * var_y) : 1.0;
+	} else {
+		/* no spread in load, assume busy% grows in proportion */
+		b = sx > 0.0 ? sy / sx : 0.0;
+		a = 0.0;
+		r2 = NAN;
+	}
+	x = sx / n;
+
+	fprintf(f, "what-if model: busy%% = %.2f + %.5f * MB/s (r^2 %.3f, %.0f windows)\n",
+		a, b, r2, n);
+	fprintf(f, "  now        %9.1f MB/s  busy %6.2f%%  headroom %6.2f%%\n",
+		x, busy_at(a, b, x), limit - busy_at(a, b, x));
+
+	for (i = 0; i < num_scales; i++) {
+		idx = scales[i].filter - filters + 1;
+		if (!master_windows[idx]) {
+			fprintf(f, "  %-10s no sweep windows yet, left out\n",
+				scales[i].filter->name);
+			continue;
+		}
+		mbps = master_sum[idx] / master_windows[idx];
+		extra += mbps * (scales[i].factor - 1.0);
+		fprintf(f, "  %-10s %9.1f MB/s  x%.2f  %+9.1f MB/s\n",
+			scales[i].filter->name, mbps, scales[i].factor,
+			mbps * (scales[i].factor - 1.0));
+	}
+
+	busy = busy_at(a, b, x + extra);
+	fprintf(f, "  projected  %9.1f MB/s  busy %6.2f%%  headroom %6.2f%%%s\n",
+		x + extra, busy, limit - busy,
+		busy >= limit ? "  SATURATED" : "");
+
+	if (b <= 0.0)
+		return;
+
+	/* how far the change and all traffic alike can grow until the limit */
+	if (extra > 0.0) {
+		k = (limit - busy_at(a, b, x)) / (b * extra);
+		fprintf(f, "  saturation at %.2fx the projected change (%.1f MB/s)\n",
+			k, x + k * extra);
+	}
+	if (x > 0.0) {
+		k = (limit - a) / (b * x);
+		fprintf(f, "  saturation at %.2fx the current traffic (%.1f MB/s)\n",
+			k, k * x);
+	}
+}